@@ -19,8 +19,470 @@
 
 #include "chartitem.h"
 
+#include <QFile>
+#include <QPainter>
+
+#include <qnumeric.h>
+
+#include <qwt_clipper.h>
+#include <qwt_painter.h>
+#include <qwt_scale_map.h>
+
 namespace Caneda
 {
+    /*************************************************************************
+     *                           ChartSampleStore                            *
+     *************************************************************************/
+    //! \brief Constructor.
+    ChartSampleStore::ChartSampleStore() :
+        m_file(0),
+        m_map(0),
+        m_mapSize(0)
+    {
+    }
+
+    //! \brief Destructor. Unmaps the raw file, if any.
+    ChartSampleStore::~ChartSampleStore()
+    {
+        if(m_file) {
+            if(m_map) {
+                m_file->unmap(m_map);
+            }
+            m_file->close();
+            delete m_file;
+        }
+    }
+
+    /*!
+     * \brief Maps the contents of file \a fileName into memory.
+     *
+     * The file is kept open (and mapped) until the store is destroyed, so
+     * that mapped columns can be read at any time without copying the file
+     * contents.
+     *
+     * If a file is already mapped, it is mapped again with its current size.
+     * This is used to follow a raw file while it is still being written, and
+     * updates the address of every mapped column.
+     *
+     * \return True on success, false otherwise.
+     * \sa addMappedColumn()
+     */
+    bool ChartSampleStore::mapFile(const QString &fileName)
+    {
+        QFile *file = m_file;
+        if(!file) {
+            file = new QFile(fileName);
+            if(!file->open(QIODevice::ReadOnly)) {
+                delete file;
+                return false;
+            }
+        }
+
+        const qint64 fileSize = file->size();
+        uchar *map = fileSize > 0 ? file->map(0, fileSize) : 0;
+        if(!map) {
+            if(file != m_file) {
+                delete file;
+            }
+            return false;
+        }
+
+        if(m_map) {
+            m_file->unmap(m_map);
+        }
+
+        m_file = file;
+        m_map = map;
+        m_mapSize = fileSize;
+
+        for(int i = 0; i < m_columns.size(); ++i) {
+            if(m_columns.at(i).owned < 0) {
+                m_columns[i].data = m_map + m_columns.at(i).offset;
+            }
+        }
+
+        return true;
+    }
+
+    /*!
+     * \brief Adds a new column pointing into the mapped file.
+     *
+     * \param offset Offset in bytes of the first sample in the mapped file.
+     * \param stride Distance in bytes between consecutive samples.
+     * \param size Number of samples in the column.
+     * \return Index of the new column.
+     *
+     * \sa mapFile()
+     */
+    int ChartSampleStore::addMappedColumn(qint64 offset, int stride, int size)
+    {
+        Column column;
+        column.data = m_map + offset;
+        column.offset = offset;
+        column.stride = stride;
+        column.size = size;
+        column.owned = -1;
+
+        m_columns.append(column);
+        m_stats.append(ColumnStats());
+        return m_columns.size() - 1;
+    }
+
+    /*!
+     * \brief Adds a new column with the given \a values.
+     *
+     * The values are implicitly shared, so the caller should not keep
+     * modifying its own copy after adding it to the store.
+     *
+     * \return Index of the new column.
+     * \sa appendToColumn()
+     */
+    int ChartSampleStore::addColumn(const QVector<double> &values)
+    {
+        m_ownedColumns.append(values);
+
+        Column column;
+        column.data = reinterpret_cast<const uchar*>(m_ownedColumns.last().constData());
+        column.offset = 0;
+        column.stride = sizeof(double);
+        column.size = values.size();
+        column.owned = m_ownedColumns.size() - 1;
+
+        m_columns.append(column);
+        m_stats.append(ColumnStats());
+        return m_columns.size() - 1;
+    }
+
+    /*!
+     * \brief Sets the number of samples available in mapped \a column.
+     *
+     * This is used when the raw file grows, after mapping it again. Only the
+     * statistics and envelope of the new samples are calculated on the next
+     * request.
+     *
+     * \sa mapFile()
+     */
+    void ChartSampleStore::setColumnSize(int column, int size)
+    {
+        Column &c = m_columns[column];
+        if(c.owned >= 0 || c.size == size) {
+            return;
+        }
+
+        if(size < c.size) {
+            m_stats[column] = ColumnStats();
+            invalidateEnvelope(column);
+        }
+        c.size = size;
+    }
+
+    /*!
+     * \brief Appends \a values to the end of owned \a column.
+     *
+     * \sa addColumn()
+     */
+    void ChartSampleStore::appendToColumn(int column, const QVector<double> &values)
+    {
+        Column &c = m_columns[column];
+        if(c.owned < 0 || values.isEmpty()) {
+            return;
+        }
+
+        QVector<double> &owned = m_ownedColumns[c.owned];
+        owned += values;
+
+        c.data = reinterpret_cast<const uchar*>(owned.constData());
+        c.size = owned.size();
+    }
+
+    /*!
+     * \brief Returns the range of the values of \a column.
+     *
+     * The range is calculated only once, and cached for later calls, as it
+     * is used by every curve (of every view) referencing the column.
+     */
+    QwtInterval ChartSampleStore::range(int column) const
+    {
+        updateStats(column);
+        return m_stats.at(column).range;
+    }
+
+    /*!
+     * \brief Returns true if the values of \a column never decrease.
+     *
+     * This is usually the case of time and frequency bases, and allows
+     * searching the column for a given value.
+     *
+     * \sa lowerBound()
+     */
+    bool ChartSampleStore::isIncreasing(int column) const
+    {
+        updateStats(column);
+        return m_stats.at(column).increasing;
+    }
+
+    /*!
+     * \brief Returns the index of the first sample of \a column not less than
+     * \a value, or the column size if there is no such sample.
+     *
+     * The column must be sorted in increasing order.
+     *
+     * \sa isIncreasing()
+     */
+    int ChartSampleStore::lowerBound(int column, double value) const
+    {
+        int first = 0;
+        int count = size(column);
+
+        while(count > 0) {
+            const int step = count / 2;
+            if(this->value(column, first + step) < value) {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else {
+                count = step;
+            }
+        }
+
+        return first;
+    }
+
+    /*!
+     * \brief Returns the min/max envelope of \a column.
+     *
+     * The envelope is built the first time it is needed, and then shared by
+     * every curve (of every view) referencing the column. If the column grew
+     * since then, the envelope is extended with the new samples only.
+     */
+    const ChartEnvelope& ChartSampleStore::envelope(int column) const
+    {
+        if(m_envelopes.size() < m_columns.size()) {
+            m_envelopes.resize(m_columns.size());
+        }
+
+        m_envelopes[column].update(this, column);
+
+        return m_envelopes.at(column);
+    }
+
+    /*!
+     * \brief Calculates the range and ordering of \a column, if not yet done.
+     *
+     * Only the samples added since the last call are visited, so following a
+     * growing column does not walk the whole column again.
+     */
+    void ChartSampleStore::updateStats(int column) const
+    {
+        ColumnStats &stats = m_stats[column];
+
+        const int count = size(column);
+        if(stats.count >= count) {
+            return;
+        }
+
+        double min = stats.range.minValue();
+        double max = stats.range.maxValue();
+        bool increasing = stats.increasing;
+        bool empty = !stats.range.isValid();
+        double previous = stats.last;
+
+        for(int i = stats.count; i < count; ++i) {
+            const double val = value(column, i);
+            if(qIsNaN(val)) {
+                increasing = false;
+                continue;
+            }
+
+            if(!empty && val < previous) {
+                increasing = false;
+            }
+            previous = val;
+
+            if(empty) {
+                min = max = val;
+                empty = false;
+            }
+            else if(val < min) {
+                min = val;
+            }
+            else if(val > max) {
+                max = val;
+            }
+        }
+
+        if(!empty) {
+            stats.range = QwtInterval(min, max);
+        }
+        stats.increasing = increasing;
+        stats.count = count;
+        stats.last = previous;
+    }
+
+    //! \brief Drops the cached envelope of \a column, to be built again on demand.
+    void ChartSampleStore::invalidateEnvelope(int column)
+    {
+        if(column < m_envelopes.size()) {
+            m_envelopes[column] = ChartEnvelope();
+        }
+    }
+
+    /*************************************************************************
+     *                             ChartEnvelope                             *
+     *************************************************************************/
+    /*!
+     * \brief Updates the envelope pyramid of \a column of \a store.
+     *
+     * Only the buckets holding samples added since the last call are
+     * calculated: the trailing (partial) bucket of each level is calculated
+     * again, and the new buckets are appended. If the column shrinked, the
+     * whole pyramid is built again.
+     *
+     * Levels are added until only one bucket remains, so the memory used by
+     * the whole pyramid is about a quarter of the samples themselves.
+     */
+    void ChartEnvelope::update(const ChartSampleStore *store, int column)
+    {
+        const int count = store->size(column);
+        if(count == m_count) {
+            return;
+        }
+
+        if(count < m_count) {
+            m_levels.clear();
+            m_count = 0;
+        }
+
+        if(count <= baseBucketSize) {
+            m_levels.clear();
+            m_count = count;
+            return;
+        }
+
+        // First level, built from the samples themselves
+        int firstBucket = m_count / baseBucketSize;
+        if(m_levels.isEmpty()) {
+            m_levels.append(QVector<int>());
+            firstBucket = 0;
+        }
+
+        QVector<int> &level = m_levels[0];
+        level.resize((count + baseBucketSize - 1) / baseBucketSize * 2);
+
+        for(int bucket = firstBucket, first = firstBucket * baseBucketSize; first < count;
+                ++bucket, first += baseBucketSize) {
+            const int last = qMin(first + baseBucketSize, count);
+
+            int minIdx = first;
+            int maxIdx = first;
+            double min = store->value(column, first);
+            double max = min;
+
+            for(int i = first + 1; i < last; ++i) {
+                const double val = store->value(column, i);
+                if(val < min) {
+                    min = val;
+                    minIdx = i;
+                }
+                else if(val > max) {
+                    max = val;
+                    maxIdx = i;
+                }
+            }
+
+            level[2*bucket] = minIdx;
+            level[2*bucket + 1] = maxIdx;
+        }
+
+        // Following levels, merging two buckets of the previous level
+        for(int index = 1; m_levels.at(index - 1).size() > 2; ++index) {
+            if(index == m_levels.size()) {
+                m_levels.append(QVector<int>());
+            }
+
+            const QVector<int> &previous = m_levels.at(index - 1);
+            QVector<int> &next = m_levels[index];
+            const int buckets = previous.size() / 2;
+
+            // Buckets of this level merging a changed bucket of the previous one
+            firstBucket = firstBucket / 2 * 2;
+            next.resize((buckets + 1) / 2 * 2);
+
+            for(int bucket = firstBucket; bucket < buckets; bucket += 2) {
+                int minIdx = previous.at(2*bucket);
+                int maxIdx = previous.at(2*bucket + 1);
+
+                if(bucket + 1 < buckets) {
+                    const int otherMin = previous.at(2*bucket + 2);
+                    const int otherMax = previous.at(2*bucket + 3);
+
+                    if(store->value(column, otherMin) < store->value(column, minIdx)) {
+                        minIdx = otherMin;
+                    }
+                    if(store->value(column, otherMax) > store->value(column, maxIdx)) {
+                        maxIdx = otherMax;
+                    }
+                }
+
+                next[bucket] = minIdx;
+                next[bucket + 1] = maxIdx;
+            }
+
+            firstBucket /= 2;
+        }
+
+        m_count = count;
+    }
+
+    /*************************************************************************
+     *                           ChartSeriesData                             *
+     *************************************************************************/
+    /*!
+     * \brief Constructor.
+     *
+     * \param store Store holding the samples.
+     * \param xColumn Column of the store used for the x values.
+     * \param yColumn Column of the store used for the y values.
+     */
+    ChartSeriesData::ChartSeriesData(const ChartSampleStorePtr &store,
+                                     int xColumn, int yColumn) :
+        m_store(store),
+        m_xColumn(xColumn),
+        m_yColumn(yColumn)
+    {
+    }
+
+    //! \brief Returns the number of samples.
+    size_t ChartSeriesData::size() const
+    {
+        return qMin(m_store->size(m_xColumn), m_store->size(m_yColumn));
+    }
+
+    //! \brief Returns the sample with index \a i.
+    QPointF ChartSeriesData::sample(size_t i) const
+    {
+        return QPointF(m_store->value(m_xColumn, int(i)),
+                       m_store->value(m_yColumn, int(i)));
+    }
+
+    /*!
+     * \brief Returns the bounding rectangle of the samples.
+     *
+     * The rectangle is built from the ranges cached by the store, so that
+     * the samples are walked only once no matter how many curves share them.
+     * It is not cached here, as the columns may grow while a simulation is
+     * still running.
+     */
+    QRectF ChartSeriesData::boundingRect() const
+    {
+        const QwtInterval x = m_store->range(m_xColumn);
+        const QwtInterval y = m_store->range(m_yColumn);
+        return QRectF(x.minValue(), y.minValue(), x.width(), y.width());
+    }
+
+    /*************************************************************************
+     *                             ChartSeries                               *
+     *************************************************************************/
     /*!
      * \brief Constructor
      *
@@ -30,4 +492,130 @@ namespace Caneda
     {
     }
 
+    /*!
+     * \brief Sets the curve samples to the given columns of a store.
+     *
+     * \param store Store holding the samples.
+     * \param xColumn Column of the store used for the x values.
+     * \param yColumn Column of the store used for the y values.
+     *
+     * \sa ChartSampleStore, ChartSeriesData
+     */
+    void ChartSeries::setSampleColumns(const ChartSampleStorePtr &store,
+                                       int xColumn, int yColumn)
+    {
+        setData(new ChartSeriesData(store, xColumn, yColumn));
+    }
+
+    /*!
+     * \brief Creates a new curve, sharing the samples of this curve.
+     *
+     * This is used to be able to attach the same curve to different views,
+     * as a QwtPlotCurve can only be attached to one plot at a time. The new
+     * curve references the same sample store, so no samples are copied.
+     */
+    ChartSeries* ChartSeries::copy() const
+    {
+        ChartSeries *curve = new ChartSeries();
+        curve->setTitle(title());
+        curve->setType(type());
+
+        const ChartSeriesData *samples = dynamic_cast<const ChartSeriesData*>(data());
+        if(samples) {
+            curve->setSampleColumns(samples->store(), samples->xColumn(), samples->yColumn());
+        }
+
+        return curve;
+    }
+
+    /*!
+     * \brief Draws the samples in the range [from, to].
+     *
+     * Only the samples inside the current x axis interval are drawn. If
+     * there are many more visible samples than pixels available, instead of
+     * drawing every sample the most suitable level of the min/max envelope of
+     * the curve is drawn (see ChartEnvelope). Drawing the minimum and the
+     * maximum of each bucket keeps all the peaks of the waveform, while
+     * making the cost of a redraw independent of the number of samples.
+     *
+     * \sa ChartEnvelope
+     */
+    void ChartSeries::drawSeries(QPainter *painter, const QwtScaleMap &xMap,
+            const QwtScaleMap &yMap, const QRectF &canvasRect,
+            int from, int to) const
+    {
+        const ChartSeriesData *samples = dynamic_cast<const ChartSeriesData*>(data());
+        if(!samples || style() != QwtPlotCurve::Lines || from > 0 ||
+                (to >= 0 && to < int(dataSize()) - 1)) {
+            QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+            return;
+        }
+
+        const ChartSampleStore *store = samples->store().constData();
+        const int xColumn = samples->xColumn();
+        const int yColumn = samples->yColumn();
+
+        to = int(dataSize()) - 1;
+        if(to <= 0 || !store->isIncreasing(xColumn)) {
+            QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+            return;
+        }
+
+        // Limit the samples to the visible x interval (plus one sample at
+        // each side, to draw the lines going out of the canvas).
+        const double lower = qMin(xMap.s1(), xMap.s2());
+        const double upper = qMax(xMap.s1(), xMap.s2());
+        from = qMax(store->lowerBound(xColumn, lower) - 1, 0);
+        to = qMin(store->lowerBound(xColumn, upper), to);
+
+        // Select the coarsest level with at least one bucket per pixel.
+        const int visible = to - from + 1;
+        const int pixels = qMax(int(canvasRect.width()), 1);
+        const ChartEnvelope &envelope = store->envelope(yColumn);
+
+        int level = -1;
+        while(level + 1 < envelope.levelCount() &&
+                visible / envelope.bucketSize(level + 1) >= pixels) {
+            ++level;
+        }
+
+        if(level < 0) {
+            QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+            return;
+        }
+
+        // Draw the minimum and maximum of each bucket, in the same order
+        // they appear in the waveform.
+        const int firstBucket = from / envelope.bucketSize(level);
+        const int lastBucket = qMin(to / envelope.bucketSize(level), envelope.bucketCount(level) - 1);
+
+        QPolygonF polyline;
+        polyline.reserve(2 * (lastBucket - firstBucket + 1));
+
+        for(int bucket = firstBucket; bucket <= lastBucket; ++bucket) {
+            const int minIdx = envelope.minIndex(level, bucket);
+            const int maxIdx = envelope.maxIndex(level, bucket);
+            const int firstIdx = qMin(minIdx, maxIdx);
+            const int secondIdx = qMax(minIdx, maxIdx);
+
+            polyline << QPointF(xMap.transform(store->value(xColumn, firstIdx)),
+                                yMap.transform(store->value(yColumn, firstIdx)));
+            if(secondIdx != firstIdx) {
+                polyline << QPointF(xMap.transform(store->value(xColumn, secondIdx)),
+                                    yMap.transform(store->value(yColumn, secondIdx)));
+            }
+        }
+
+        if(testPaintAttribute(QwtPlotCurve::ClipPolygons)) {
+            const qreal penWidth = qMax(pen().widthF(), qreal(1.0));
+            const QRectF clipRect = canvasRect.adjusted(-penWidth, -penWidth, penWidth, penWidth);
+            polyline = QwtClipper::clipPolygonF(clipRect, polyline);
+        }
+
+        painter->save();
+        painter->setPen(pen());
+        QwtPainter::drawPolyline(painter, polyline);
+        painter->restore();
+    }
+
 } // namespace Caneda
@@ -20,12 +20,240 @@
 #ifndef CHART_ITEM_H
 #define CHART_ITEM_H
 
+#include <QList>
+#include <QSharedData>
 #include <QString>
+#include <QtEndian>
+#include <QVector>
 
+#include <cstring>
+
+#include <qwt_interval.h>
 #include <qwt_plot_curve.h>
+#include <qwt_series_data.h>
+
+// Forward declarations
+class QFile;
 
 namespace Caneda
 {
+    // Forward declarations
+    class ChartSampleStore;
+
+    /*!
+     * \brief Multi-resolution min/max envelope of a waveform.
+     *
+     * This class holds a pyramid of decimation levels of one column of a
+     * ChartSampleStore. On the first level, the samples are grouped into
+     * buckets of baseBucketSize consecutive samples, and for each bucket the
+     * indexes of its minimum and maximum samples are kept. Each following
+     * level merges two buckets of the previous one.
+     *
+     * When drawing a waveform with many more samples than available pixels,
+     * the level with about one bucket per pixel is used, drawing only the
+     * minimum and maximum of each bucket. In this way the cost of a redraw
+     * depends on the size of the screen and not on the number of samples,
+     * while the peaks of the waveform are still drawn exactly.
+     *
+     * When the column grows, only the trailing buckets of each level are
+     * calculated again, so following a simulation still running does not
+     * walk all of its samples on every update.
+     *
+     * \sa ChartSampleStore, ChartSeries
+     */
+    class ChartEnvelope
+    {
+    public:
+        //! \brief Number of samples in each bucket of the first level.
+        enum { baseBucketSize = 8 };
+
+        ChartEnvelope() : m_count(0) {}
+
+        void update(const ChartSampleStore *store, int column);
+
+        //! \brief Returns the number of levels of the pyramid.
+        int levelCount() const { return m_levels.size(); }
+        //! \brief Returns the number of samples grouped in each bucket of \a level.
+        int bucketSize(int level) const { return baseBucketSize << level; }
+        //! \brief Returns the number of buckets of \a level.
+        int bucketCount(int level) const { return m_levels.at(level).size() / 2; }
+
+        //! \brief Returns the index of the minimum sample of \a bucket in \a level.
+        int minIndex(int level, int bucket) const { return m_levels.at(level).at(2*bucket); }
+        //! \brief Returns the index of the maximum sample of \a bucket in \a level.
+        int maxIndex(int level, int bucket) const { return m_levels.at(level).at(2*bucket + 1); }
+
+    private:
+        //! \brief Pairs of minimum and maximum sample indexes, for each level.
+        QVector<QVector<int> > m_levels;
+        //! \brief Number of samples already accounted for.
+        int m_count;
+    };
+
+    /*!
+     * \brief Columnar storage of simulation waveform samples.
+     *
+     * Each column holds the samples of one simulation variable, the first one
+     * usually being the time (or frequency) base of the rest of the columns.
+     * A column can point straight into a memory mapped raw file (in which
+     * case the samples of all variables are interleaved, and each column has
+     * a stride equal to the size of a full data point), or into an array
+     * owned by this class (for data that must be converted before being
+     * plotted, as for example complex numbers).
+     *
+     * Each ChartScene owns one store with all of its waveforms. This inherits
+     * QSharedData which takes care of reference counting, so that the samples
+     * are shared (and not copied) by all the curves of all the views attached
+     * to the same scene. In this way, the memory used does not grow with the
+     * number of views.
+     *
+     * Columns can grow while a simulation is still writing its raw file. The
+     * file is then mapped again with its new size (see mapFile()), and the
+     * cached statistics are extended with the new samples only.
+     *
+     * \sa ChartSeriesData, ChartScene
+     */
+    class ChartSampleStore : public QSharedData
+    {
+    public:
+        ChartSampleStore();
+        ~ChartSampleStore();
+
+        bool mapFile(const QString &fileName);
+        //! \brief Returns the mapped file contents (or 0 if not mapped).
+        const uchar* mappedData() const { return m_map; }
+        //! \brief Returns the size in bytes of the mapped file contents.
+        qint64 mappedSize() const { return m_mapSize; }
+
+        int addMappedColumn(qint64 offset, int stride, int size);
+        int addColumn(const QVector<double> &values);
+        void setColumnSize(int column, int size);
+        void appendToColumn(int column, const QVector<double> &values);
+
+        //! \brief Returns the number of columns (variables) in the store.
+        int columnCount() const { return m_columns.size(); }
+        //! \brief Returns the number of samples available in \a column.
+        int size(int column) const { return m_columns.at(column).size; }
+
+        QwtInterval range(int column) const;
+        bool isIncreasing(int column) const;
+        int lowerBound(int column, double value) const;
+        const ChartEnvelope& envelope(int column) const;
+
+        inline double value(int column, int index) const;
+        static inline double readMapped(const uchar *src);
+
+    private:
+        //! \brief Location of the samples of one column.
+        struct Column
+        {
+            const uchar *data;  //! \brief Address of the first sample.
+            qint64 offset;      //! \brief Offset of the first sample in the mapped file.
+            int stride;         //! \brief Distance in bytes between consecutive samples.
+            int size;           //! \brief Number of samples.
+            int owned;          //! \brief Index in m_ownedColumns, or -1 if mapped.
+        };
+
+        //! \brief Statistics of one column, calculated on demand.
+        struct ColumnStats
+        {
+            ColumnStats() : increasing(true), count(0), last(0.0) {}
+
+            QwtInterval range;  //! \brief Minimum and maximum values.
+            bool increasing;    //! \brief True if values never decrease.
+            int count;          //! \brief Number of samples already accounted for.
+            double last;        //! \brief Last non NaN sample accounted for.
+        };
+
+        void updateStats(int column) const;
+        void invalidateEnvelope(int column);
+
+        QVector<Column> m_columns;
+        QList<QVector<double> > m_ownedColumns;  //! \brief Converted (not mapped) samples.
+
+        mutable QVector<ColumnStats> m_stats;        //! \brief Cached statistics of each column.
+        mutable QVector<ChartEnvelope> m_envelopes;  //! \brief Cached envelope of each column.
+
+        QFile *m_file;     //! \brief Mapped raw file.
+        uchar *m_map;      //! \brief Mapped raw file contents.
+        qint64 m_mapSize;  //! \brief Size of the mapped raw file contents.
+    };
+
+    typedef QExplicitlySharedDataPointer<ChartSampleStore> ChartSampleStorePtr;
+
+    /*!
+     * \brief Returns the sample with index \a index from column \a column.
+     *
+     * \sa readMapped()
+     */
+    inline double ChartSampleStore::value(int column, int index) const
+    {
+        const Column &c = m_columns.at(column);
+        const uchar *src = c.data + qint64(index) * c.stride;
+
+        if(c.owned < 0) {
+            return readMapped(src);
+        }
+
+        double val;
+        memcpy(&val, src, sizeof(double));
+        return val;
+    }
+
+    /*!
+     * \brief Reads a double from the mapped raw file at address \a src.
+     *
+     * Mapped samples are stored as 64 bit little endian floats, and are not
+     * necessarily aligned, so they are always read byte-wise.
+     */
+    inline double ChartSampleStore::readMapped(const uchar *src)
+    {
+        double val;
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        quint64 bits = qFromLittleEndian<quint64>(src);
+        memcpy(&val, &bits, sizeof(double));
+#else
+        memcpy(&val, src, sizeof(double));
+#endif
+
+        return val;
+    }
+
+    /*!
+     * \brief This class provides a QwtSeriesData adapter over the columns of
+     * a ChartSampleStore.
+     *
+     * Instead of copying the samples into a new array (as done by
+     * QwtPlotCurve::setSamples()), curves using this class read the x and y
+     * values directly from the store. Any number of curves can use the same
+     * columns (for example the time base) as each adapter only references
+     * the shared store.
+     *
+     * \sa ChartSampleStore, ChartSeries
+     */
+    class ChartSeriesData : public QwtSeriesData<QPointF>
+    {
+    public:
+        ChartSeriesData(const ChartSampleStorePtr &store, int xColumn, int yColumn);
+
+        //! \brief Returns the store holding the samples.
+        ChartSampleStorePtr store() const { return m_store; }
+        //! \brief Returns the column of the store used for the x values.
+        int xColumn() const { return m_xColumn; }
+        //! \brief Returns the column of the store used for the y values.
+        int yColumn() const { return m_yColumn; }
+
+        virtual size_t size() const;
+        virtual QPointF sample(size_t i) const;
+        virtual QRectF boundingRect() const;
+
+    private:
+        ChartSampleStorePtr m_store;
+        int m_xColumn;
+        int m_yColumn;
+    };
+
     /*!
      * \brief This class extends the QwtPlotCurve class, providing some
      * special properties needed for Caneda.
@@ -42,6 +270,14 @@ namespace Caneda
         //! \brief Sets the type of curve
         void setType(const QString& type) { m_type = type; }
 
+        void setSampleColumns(const ChartSampleStorePtr &store, int xColumn, int yColumn);
+
+        ChartSeries* copy() const;
+
+        virtual void drawSeries(QPainter *painter, const QwtScaleMap &xMap,
+                const QwtScaleMap &yMap, const QRectF &canvasRect,
+                int from, int to) const;
+
     private:
         QString m_type;  //! \brief Type of curve (voltage, current, etc)
     };
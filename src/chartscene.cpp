@@ -26,17 +26,80 @@ namespace Caneda
      *
      * \param parent Parent of the scene.
      */
-    ChartScene::ChartScene(QWidget *parent) : QWidget(parent)
+    ChartScene::ChartScene(QWidget *parent) :
+        QWidget(parent),
+        m_currentPlot(0),
+        m_sampleStore(new ChartSampleStore)
     {
     }
 
+    //! \brief Destructor.
+    ChartScene::~ChartScene()
+    {
+        for(int i = 0; i < m_items.size(); ++i) {
+            qDeleteAll(m_items.at(i));
+        }
+    }
+
+    //! \brief Returns a list of all items of \a plot in descending stacking
+    QList<ChartSeries*> ChartScene::items(int plot) const
+    {
+        return m_items.value(plot);
+    }
+
+    /*!
+     * \brief Adds \a item to the given \a plot of this scene. This scene
+     * takes ownership of the item.
+     *
+     * \sa addPlot()
+     */
+    void ChartScene::addItem(ChartSeries *item, int plot)
+    {
+        m_items[plot].append(item);
+    }
+
+    /*!
+     * \brief Adds a new empty plot named \a name to the scene.
+     *
+     * \return Index of the new plot.
+     * \sa addItem()
+     */
+    int ChartScene::addPlot(const QString &name)
+    {
+        m_plotNames.append(name);
+        m_items.append(QList<ChartSeries*>());
+
+        return m_items.size() - 1;
+    }
+
+    /*!
+     * \brief Sets the plot displayed by the views to \a plot.
+     *
+     * The attached views are notified through the currentPlotChanged()
+     * signal, to update their curves.
+     */
+    void ChartScene::setCurrentPlot(int plot)
+    {
+        if(plot < 0 || plot >= m_items.size()) {
+            return;
+        }
+
+        m_currentPlot = plot;
+        emit currentPlotChanged();
+    }
+
     /*!
-     * \brief Adds or moves the item and all its childen to this scene. This
-     * scene takes ownership of the item.
+     * \brief Notifies the attached views that new samples were added to the
+     * items of the current plot.
+     *
+     * This is used while following a running simulation, so that the views
+     * redraw the curves without rebuilding them.
+     *
+     * \sa samplesChanged()
      */
-    void ChartScene::addItem(ChartSeries *item)
+    void ChartScene::updateSamples()
     {
-        m_items.append(item);
+        emit samplesChanged();
     }
 
 } // namespace Caneda
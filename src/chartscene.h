@@ -22,6 +22,7 @@
 
 #include <chartitem.h>
 
+#include <QStringList>
 #include <QWidget>
 
 namespace Caneda
@@ -36,7 +37,15 @@ namespace Caneda
      * attached to the same scene, providing different viewports into the same
      * data set (for example, when using split views).
      *
-     * \sa ChartView
+     * The samples of all waveforms are kept in a single ChartSampleStore
+     * owned by the scene, and shared by the curves of all attached views.
+     *
+     * A simulation can produce several plots (for example an operating point
+     * followed by a transient analysis), each one with its own set of items.
+     * Only the items of the current plot are displayed by the views, and the
+     * items of a plot may be added only when the plot is first selected.
+     *
+     * \sa ChartView, ChartSampleStore
      */
     class ChartScene : public QWidget
     {
@@ -44,13 +53,35 @@ namespace Caneda
 
     public:
         explicit ChartScene(QWidget *parent = 0);
+        ~ChartScene();
+
+        //! \brief Returns a list of all items of the current plot in descending stacking
+        QList<ChartSeries*> items() const { return items(m_currentPlot); }
+        QList<ChartSeries*> items(int plot) const;
+        void addItem(ChartSeries *item, int plot);
+
+        int addPlot(const QString &name);
+        //! \brief Returns the names of all plots in the scene
+        QStringList plotNames() const { return m_plotNames; }
 
-        //! \brief Returns a list of all items in the scene in descending stacking
-        QList<ChartSeries*> items() const { return m_items; }
-        void addItem(ChartSeries *item);
+        //! \brief Returns the index of the plot displayed by the views
+        int currentPlot() const { return m_currentPlot; }
+        void setCurrentPlot(int plot);
+        void updateSamples();
+
+        //! \brief Returns the store holding the samples of all items in the scene
+        ChartSampleStorePtr sampleStore() const { return m_sampleStore; }
+
+    Q_SIGNALS:
+        void currentPlotChanged();
+        void samplesChanged();
 
     private:
-        QList<ChartSeries*> m_items;  //! \brief Items available in the scene (curves, markers, etc)
+        QList<QList<ChartSeries*> > m_items;  //! \brief Items available in each plot (curves, markers, etc)
+        QStringList m_plotNames;  //! \brief Names of the plots
+        int m_currentPlot;  //! \brief Plot displayed by the views
+
+        ChartSampleStorePtr m_sampleStore;  //! \brief Samples shared by all items and views
     };
 
 } // namespace Caneda
@@ -114,6 +114,11 @@ namespace Caneda
         // Context menu event
         setContextMenuPolicy(Qt::CustomContextMenu);
         connect(this, SIGNAL(customContextMenuRequested(const QPoint &)), this, SLOT(contextMenuEvent(const QPoint &)));
+
+        // Update the curves when selecting a different plot of the scene
+        connect(m_chartScene, SIGNAL(currentPlotChanged()), this, SLOT(populate()));
+        // Redraw the curves when new samples arrive from a running simulation
+        connect(m_chartScene, SIGNAL(samplesChanged()), this, SLOT(updateSamples()));
     }
 
     void ChartView::zoomIn()
@@ -136,22 +141,31 @@ namespace Caneda
         m_zoomer->zoom(0);
     }
 
-    //! \brief Adds all items available in the scene to the plot widget.
+    /*!
+     * \brief Adds all items available in the current plot of the scene to
+     * the plot widget, replacing any previous items.
+     */
     void ChartView::populate()
     {
         QList<ChartSeries*> m_items = m_chartScene->items();
 
+        // Remove the curves of the previously displayed plot
+        detachItems(QwtPlotItem::Rtti_PlotCurve, true);
+
+        if(m_items.isEmpty()) {
+            replot();
+            return;
+        }
+
         QColor color = QColor(0, 0, 0);
         int colorIndex= 0;
         int valueIndex = 255;
 
         // Attach the items to the plot
         foreach(ChartSeries *item, m_items) {
-            // Recreate the curve to be able to attach
-            // the same curve to different views
-            ChartSeries *newCurve = new ChartSeries();
-            newCurve->setData(item->data());
-            newCurve->setTitle(item->title());
+            // Recreate the curve to be able to attach the same curve to
+            // different views. The samples are shared with the scene.
+            ChartSeries *newCurve = item->copy();
             newCurve->attach(this);
 
             // Set the correct axis depending on the curve magnitude
@@ -198,6 +212,7 @@ namespace Caneda
             setAxisTitle(xBottom, QwtText(tr("Time [s]")));
             setAxisTitle(yLeft, QwtText(tr("Voltage [V]")));
             setAxisTitle(yRight, QwtText(tr("Current [A]")));
+            setLogAxis(QwtPlot::xBottom, false);
         }
         else {
             setAxisTitle(xBottom, QwtText(tr("Frequency [Hz]")));
@@ -208,6 +223,11 @@ namespace Caneda
 
         enableAxis(yRight);  // Always enable the y axis
 
+        // Reset any previous zoom, to display the whole plot
+        setAxisAutoScale(xBottom);
+        setAxisAutoScale(yLeft);
+        setAxisAutoScale(yRight);
+
         // Refresh the plot
         replot();
 
@@ -217,6 +237,25 @@ namespace Caneda
         m_zoomer->setZoomBase();
     }
 
+    /*!
+     * \brief Redraws the curves after new samples were added to the scene.
+     *
+     * While the axes are autoscaled, the zoom base follows the growing
+     * waveforms. Once the user zooms or pans the plot, the displayed region
+     * is kept unchanged.
+     */
+    void ChartView::updateSamples()
+    {
+        const bool autoScale = axisAutoScale(xBottom) && axisAutoScale(yLeft) &&
+                axisAutoScale(yRight);
+
+        replot();
+
+        if(autoScale) {
+            m_zoomer->setZoomBase(false);
+        }
+    }
+
     /*!
      * \brief Set axis scale logarithmic state.
      *
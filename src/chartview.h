@@ -85,7 +85,9 @@ namespace Caneda
         virtual void zoomFitInBest();
         virtual void zoomOriginal();
 
-        void populate();
+        //! \brief Returns the scene displayed by this view
+        ChartScene* chartScene() const { return m_chartScene; }
+
         void setLogAxis(QwtPlot::Axis axis, bool logarithmic);
         bool isLogAxis(QwtPlot::Axis axis);
 
@@ -95,6 +97,8 @@ namespace Caneda
         void exportImage(QPaintDevice &device);
 
     public Q_SLOTS:
+        void populate();
+        void updateSamples();
         void launchPropertiesDialog();
         void contextMenuEvent(const QPoint &pos);
 
@@ -21,6 +21,7 @@
 #include "component.h"
 
 #include "global.h"
+#include "graphicsscene.h"
 #include "library.h"
 #include "port.h"
 #include "settings.h"
@@ -30,6 +31,7 @@
 #include <QFile>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
+#include <QtMath>
 
 namespace Caneda
 {
@@ -65,6 +67,7 @@ namespace Caneda
         properties->setPropertyMap(other->properties->propertyMap());
 
         models = other->models;
+        modelTemplates = other->modelTemplates;
     }
 
     /*!
@@ -187,6 +190,44 @@ namespace Caneda
         return d->models[type];
     }
 
+    /*!
+     * \brief Returns the specified model of a component, already parsed.
+     *
+     * The model templates are parsed when the component is loaded into a
+     * library. If the component data was not loaded that way, the model is
+     * parsed on the fly.
+     *
+     * \param type The type of model to return (for example, spice).
+     * \return ModelTemplate with the component's parsed model.
+     *
+     * \sa model(), \ref ModelsFormat.
+     */
+    ModelTemplate Component::modelTemplate(const QString& type) const
+    {
+        QMap<QString, ModelTemplate>::const_iterator it = d->modelTemplates.constFind(type);
+        if(it != d->modelTemplates.constEnd()) {
+            return it.value();
+        }
+
+        return ModelTemplate(d->models.value(type));
+    }
+
+    /*!
+     * \brief Notifies the scenes the component is removed from and inserted
+     * into, as they must update their netlists.
+     */
+    QVariant Component::itemChange(GraphicsItemChange change, const QVariant &value)
+    {
+        if(change == ItemSceneChange || change == ItemSceneHasChanged) {
+            GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+            if(_scene) {
+                _scene->notifyComponentChanged(this);
+            }
+        }
+
+        return GraphicsItem::itemChange(change, value);
+    }
+
     /*!
      * \brief Paints a previously registered component.
      *
@@ -201,33 +242,35 @@ namespace Caneda
             QWidget *)
     {
         // Paint the component symbol
-        Settings *settings = Settings::instance();
+        const RenderSettings &settings = Settings::instance()->renderSettings();
         LibraryManager *libraryManager = LibraryManager::instance();
         QPainterPath symbol = libraryManager->symbolCache(name(), library());
 
         // Save pen
         QPen savedPen = painter->pen();
 
-        if(option->state & QStyle::State_Selected) {
-            // If selected, the paint is performed without the pixmap cache
-            painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
+        const bool selected = option->state & QStyle::State_Selected;
+        const qreal zoom = qSqrt(qAbs(painter->worldTransform().determinant()));
 
-            painter->drawPath(symbol);  // Draw symbol
+        if(option->levelOfDetailFromTransform(painter->worldTransform()) < Caneda::SymbolsLevelOfDetail) {
+            // If zoomed out too much, only the symbol's box is drawn
+            painter->setPen(selected ? settings.selectionPen : settings.linePen);
+            painter->setBrush(Qt::NoBrush);
+
+            painter->drawRect(symbol.boundingRect());
         }
-        else if(painter->worldTransform().isScaling()) {
-            // If zooming, the paint is performed without the pixmap cache
-            painter->setPen(QPen(settings->currentValue("gui/lineColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
+        else if(zoom > settings.vectorZoom) {
+            // If zooming in too much, the paint is performed without the pixmap cache
+            painter->setPen(selected ? settings.selectionPen : settings.linePen);
 
             painter->drawPath(symbol);  // Draw symbol
         }
         else {
-            // Else, a pixmap cached is used
-            QPixmap pix = libraryManager->pixmapCache(name(), library());
+            // Else, a pixmap cached for the current zoom level is used
+            QPixmap pix = libraryManager->pixmapCache(name(), library(), zoom, selected);
             QRect rect =  symbol.boundingRect().toRect();
             rect.adjust(-1.0, -1.0, 1.0, 1.0);  // Adjust rect to avoid clipping when size = 1px in any dimension
-            painter->drawPixmap(rect, pix);
+            painter->drawPixmap(rect.topLeft(), pix);
         }
 
         // Restore pen
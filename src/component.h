@@ -22,6 +22,7 @@
 #define QCOMPONENT_H
 
 #include "graphicsitem.h"
+#include "modeltemplate.h"
 #include "property.h"
 
 namespace Caneda
@@ -56,6 +57,8 @@ namespace Caneda
 
         //! QMap with all the models available to the component.
         QMap<QString, QString> models;
+        //! Parsed models, to avoid parsing the syntax on each export.
+        QMap<QString, ModelTemplate> modelTemplates;
     };
 
     typedef QSharedDataPointer<ComponentData> ComponentDataPtr;
@@ -117,6 +120,7 @@ namespace Caneda
         PropertyGroup* properties() const { return d->properties; }
 
         QString model(const QString &type) const;
+        ModelTemplate modelTemplate(const QString &type) const;
 
         void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *);
 
@@ -129,6 +133,7 @@ namespace Caneda
 
     protected:
         QRectF adjustedBoundRect(const QRectF &rect);
+        QVariant itemChange(GraphicsItemChange change, const QVariant &value);
 
     public slots:
         void updateBoundingRect();
@@ -56,6 +56,7 @@ namespace Caneda
         map["gui/lineColor"] = settings->currentValue("gui/lineColor");
         map["gui/selectionColor"] = settings->currentValue("gui/selectionColor");
         map["gui/lineWidth"] = settings->currentValue("gui/lineWidth");
+        map["gui/wireLayer"] = settings->currentValue("gui/wireLayer");
 
         // Libraries group of settings
         map["libraries/schematic"] = settings->currentValue("libraries/schematic");
@@ -65,6 +66,7 @@ namespace Caneda
         map["sim/simulationCommand"] = settings->currentValue("sim/simulationCommand");
         map["sim/simulationEngine"] = settings->currentValue("sim/simulationEngine");
         map["sim/outputFormat"] = settings->currentValue("sim/outputFormat");
+        map["sim/liveWaveforms"] = settings->currentValue("sim/liveWaveforms");
 
         // Layout group of settings
         map["gui/layout/metal1"] = settings->currentValue("gui/layout/metal1");
@@ -248,6 +250,7 @@ namespace Caneda
         map["gui/lineColor"] = settings->defaultValue("gui/lineColor");
         map["gui/selectionColor"] = settings->defaultValue("gui/selectionColor");
         map["gui/lineWidth"] = settings->defaultValue("gui/lineWidth");
+        map["gui/wireLayer"] = settings->defaultValue("gui/wireLayer");
 
         // Libraries group of settings
         map["libraries/schematic"] = settings->defaultValue("libraries/schematic");
@@ -257,6 +260,7 @@ namespace Caneda
         map["sim/simulationCommand"] = settings->defaultValue("sim/simulationCommand");
         map["sim/simulationEngine"] = settings->defaultValue("sim/simulationEngine");
         map["sim/outputFormat"] = settings->defaultValue("sim/outputFormat");
+        map["sim/liveWaveforms"] = settings->defaultValue("sim/liveWaveforms");
 
         // Layout group of settings
         map["gui/layout/metal1"] = settings->defaultValue("gui/layout/metal1");
@@ -296,6 +300,7 @@ namespace Caneda
         settings->setCurrentValue("gui/selectionColor", getButtonColor(ui.buttonSelection));
 
         settings->setCurrentValue("gui/lineWidth", ui.spinWidth->value());
+        settings->setCurrentValue("gui/wireLayer", ui.checkWireLayer->isChecked());
 
         // Libraries group of settings
         QStringList newLibraries;
@@ -330,6 +335,8 @@ namespace Caneda
             settings->setCurrentValue("sim/outputFormat", QString("ascii"));
         }
 
+        settings->setCurrentValue("sim/liveWaveforms", ui.checkLiveWaveforms->isChecked());
+
         // Layout group of settings
         settings->setCurrentValue("gui/layout/metal1", getButtonColor(ui.buttonMetal1));
         settings->setCurrentValue("gui/layout/metal2", getButtonColor(ui.buttonMetal2));
@@ -367,6 +374,7 @@ namespace Caneda
         setButtonColor(ui.buttonLine, map["gui/lineColor"].value<QColor>());
         setButtonColor(ui.buttonSelection, map["gui/selectionColor"].value<QColor>());
         ui.spinWidth->setValue(map["gui/lineWidth"].toInt());
+        ui.checkWireLayer->setChecked(map["gui/wireLayer"].toBool());
 
         // Libraries group of settings
         ui.listLibraries->clear();
@@ -403,6 +411,8 @@ namespace Caneda
             ui.radioAsciiMode->setChecked(true);
         }
 
+        ui.checkLiveWaveforms->setChecked(map["sim/liveWaveforms"].toBool());
+
         // Layout group of settings
         setButtonColor(ui.buttonMetal1, map["gui/layout/metal1"].value<QColor>());
         setButtonColor(ui.buttonMetal2, map["gui/layout/metal2"].value<QColor>());
@@ -28,17 +28,23 @@
 #include "idocument.h"
 #include "library.h"
 #include "painting.h"
+#include "polarconversion.h"
 #include "port.h"
 #include "portsymbol.h"
+#include "settings.h"
 #include "wire.h"
 #include "xmlutilities.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QRegularExpression>
 #include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
 
 namespace Caneda
 {
@@ -110,10 +116,15 @@ namespace Caneda
             return false;
         }
 
+        // Defer the connection of loaded items to a single pass at the end
+        scene->beginBulkLoad();
+
         QTextStream stream(&file);
         bool result = loadFromText(stream.readAll());
         file.close();
 
+        scene->endBulkLoad();
+
         return result;
     }
 
@@ -1052,6 +1063,7 @@ namespace Caneda
                     else if(component()) {
                         // We are opening the file as a component to include it in a library
                         component()->models.insert(modelType, modelSyntax);
+                        component()->modelTemplates.insert(modelType, ModelTemplate(modelSyntax));
                     }
 
                     // Read till end element
@@ -1303,10 +1315,25 @@ namespace Caneda
     //! \brief Constructor.
     FormatSpice::FormatSpice(SchematicDocument *document) :
         QObject(document),
-        m_schematicDocument(document)
+        m_schematicDocument(document),
+        m_connectionsChanged(true)
     {
+        GraphicsScene *scene = graphicsScene();
+        if(scene) {
+            connect(scene, SIGNAL(componentChanged(Component*)), this,
+                    SLOT(componentChanged(Component*)));
+            connect(scene, SIGNAL(connectionsChanged()), this,
+                    SLOT(connectionsChanged()));
+        }
     }
 
+    /*!
+     * \brief Saves the netlist of the schematic.
+     *
+     * Only the netlist of the components changed since the last time the
+     * netlist was saved are generated again, and if the resulting netlist
+     * is the same as the one already in the file, the file is not written.
+     */
     bool FormatSpice::save()
     {
         GraphicsScene *scene = graphicsScene();
@@ -1314,6 +1341,15 @@ namespace Caneda
             return false;
         }
 
+        QString text = generateNetlist();
+        if(text.isEmpty()) {
+            qDebug() << "Looks buggy! Null data to save! Was this expected?";
+        }
+
+        if(text == m_text && QFile::exists(fileName())) {
+            return true;
+        }
+
         QFile file(fileName());
         if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
             QMessageBox::critical(0, QObject::tr("Error"),
@@ -1321,10 +1357,7 @@ namespace Caneda
             return false;
         }
 
-        QString text = generateNetlist();
-        if(text.isEmpty()) {
-            qDebug() << "Looks buggy! Null data to save! Was this expected?";
-        }
+        m_text = text;
 
         QTextStream stream(&file);
         stream << text;
@@ -1341,270 +1374,511 @@ namespace Caneda
     QString FormatSpice::fileName() const
     {
         if(m_schematicDocument) {
-            QFileInfo info(m_schematicDocument->fileName());
-            QString baseName = info.completeBaseName();
-            QString path = info.path();
-
-            return path + "/" + baseName + ".net";
+            return netlistFileName(m_schematicDocument->fileName());
         }
 
         return QString();
     }
 
+    //! \brief Returns the netlist file name corresponding to a \a schematic.
+    QString FormatSpice::netlistFileName(const QString &schematic)
+    {
+        QFileInfo info(schematic);
+        QString baseName = info.completeBaseName();
+        QString path = info.path();
+
+        return path + "/" + baseName + ".net";
+    }
+
     /*!
-     *  \brief Generate netlist
+     * \brief Helper class to expand the parsed models of the components.
      *
-     *  Iterate over all components, saving to a string the schematic netlist
-     *  according to the model provided as a set of rules. In order to do so,
-     *  the netlist topology must also be created, that is the connections
-     *  between the multiple components must be determined and numbered to be
-     *  used for the spice netlist. The set of rules used for generating the
-     *  netlist from the model is specified in \ref ModelsFormat.
+     * Walks the tokens of a ModelTemplate, appending the resulting text to
+     * the netlist and collecting the models, subcircuits, directives and
+     * schematics that must be included only once at the end of the file.
      *
-     *  \sa generateNetlistTopology(), \ref ModelsFormat
+     * \sa ModelTemplate, FormatSpice::generateNetlist(), \ref ModelsFormat
      */
-    QString FormatSpice::generateNetlist()
+    class ModelExpander
     {
-        LibraryManager *libraryManager = LibraryManager::instance();
-        QList<QGraphicsItem*> items = graphicsScene()->items();
-        QList<Component*> components = filterItems<Component>(items);
-        PortsNetlist netlist = generateNetlistTopology();
-
-        QStringList modelsList;
-        QStringList subcircuitsList;
-        QStringList directivesList;
-        QStringList schematicsList;
-
-        // Start the document and write the header
-        QString retVal;
-        retVal.append("* Spice automatic export. Generated by Caneda.\n");
-        retVal.append("\n* Spice netlist.\n");
-
-        // Copy all the elements and properties in the schematic by
-        // iterating over all schematic components.
-        // *Note*: the parsing order is important to allow, for example
-        // cascadable commands and if control statements correct extraction.
-        foreach(Component *c, components) {
-
-            // Get the spice model (multiple models may be available)
-            QString model = c->model("spice");
-
-            // ************************************************************
-            // Parse and replace the simple commands (e.g. label)
-            // ************************************************************
-            model.replace("%label", c->label());
-            model.replace("%n", "\n");
-
-            QString path = libraryManager->library(c->library())->libraryPath();
-            model.replace("%librarypath", path);
-
-            path = QFileInfo(m_schematicDocument->fileName()).absolutePath();
-            model.replace("%filepath", path);
-
-            // ************************************************************
-            // Parse and replace the commands with parameters
-            // ************************************************************
-            QStringList commands;
-            QRegularExpression re;
-            QRegularExpressionMatchIterator it;
-
-            // ************************************************************
-            // First parse the cascadable commands (e.g. properties)
-            // ************************************************************
-            commands.clear();
-            re.setPattern("(%\\w+\{([\\w+-]+)})");
-            it = re.globalMatch(model);
-            while (it.hasNext()) {
-                QRegularExpressionMatch match = it.next();
-                commands << match.captured(0);
-            }
-
-            // For each command replace the parameter with the correct value
-            for(int i=0; i<commands.size(); i++){
-
-                // Extract the parameters, removing the comand (including the
-                // "{" and the last character "}")
-                QString parameter = commands.at(i);
-                parameter.remove(QRegularExpression("(%\\w+\{)")).chop(1);
-
-                if(commands.at(i).startsWith("%port")){
-                    foreach(Port *_port, c->ports()) {
-                        if(_port->name() == parameter) {
-                            // Found the port, now look for its netlist name
-                            for(int j = 0; j < netlist.size(); ++j) {
-                                if(netlist.at(j).first == _port) {
-                                    model.replace(commands.at(i), netlist.at(j).second);
-                                }
-                            }
-                        }
+    public:
+        ModelExpander(const PortsNetlist &netlist, const QString &filePath) :
+            m_netlist(netlist),
+            m_filePath(filePath),
+            m_component(0)
+        {
+        }
+
+        //! \brief Sets the component whose model is being expanded.
+        void setComponent(Component *component, const QString &libraryPath)
+        {
+            m_component = component;
+            m_libraryPath = libraryPath;
+        }
+
+        //! \brief Appends the expansion of \a tokens to \a out.
+        void expand(const QList<ModelToken> &tokens, QString &out)
+        {
+            foreach(const ModelToken &token, tokens) {
+                switch(token.type) {
+                case ModelToken::Literal:
+                    out.append(token.text);
+                    break;
+                case ModelToken::Label:
+                    out.append(m_component->label());
+                    break;
+                case ModelToken::LibraryPath:
+                    out.append(m_libraryPath);
+                    break;
+                case ModelToken::FilePath:
+                    out.append(m_filePath);
+                    break;
+                case ModelToken::GenerateNetlist:
+                    appendSchematic();
+                    break;
+                case ModelToken::Port:
+                    appendPort(argument(token.arguments), out);
+                    break;
+                case ModelToken::Property:
+                    out.append(m_component->properties()->propertyValue(argument(token.arguments)));
+                    break;
+                case ModelToken::If:
+                    if(!argument(token.arguments).isEmpty()) {
+                        expand(token.trueValue, out);
                     }
-                }
-                else if(commands.at(i).startsWith("%property")){
-                    model.replace(commands.at(i), c->properties()->propertyValue(parameter));
+                    break;
+                case ModelToken::Model:
+                    appendUnique(m_models, argument(token.arguments));
+                    break;
+                case ModelToken::Subcircuit:
+                    appendUnique(m_subcircuits, argument(token.arguments));
+                    break;
+                case ModelToken::Directive:
+                    appendUnique(m_directives, argument(token.arguments));
+                    break;
                 }
             }
+        }
 
-            // ************************************************************
-            // Parse if control statements
-            // ************************************************************
-            commands.clear();
-            re.setPattern("(%\\w+\{([\\w =+-,]*)})");
-            it = re.globalMatch(model);
-            while (it.hasNext()) {
-                QRegularExpressionMatch match = it.next();
-                commands << match.captured(0);
-            }
+        const QStringList& models() const { return m_models; }
+        const QStringList& subcircuits() const { return m_subcircuits; }
+        const QStringList& directives() const { return m_directives; }
+        const QStringList& schematics() const { return m_schematics; }
 
-            // For each command replace the parameter with the correct value
-            for(int i=0; i<commands.size(); i++){
+    private:
+        //! \brief Returns the expansion of the arguments of a sequence.
+        QString argument(const QList<ModelToken> &tokens)
+        {
+            // Plain arguments (port and property names) need no copy
+            if(tokens.size() == 1 && tokens.first().type == ModelToken::Literal) {
+                return tokens.first().text;
+            }
 
-                // Extract the parameters, removing the comand (including the
-                // "{" and the last character "}")
-                QString parameter = commands.at(i);
-                parameter.remove(QRegularExpression("(%\\w+\{)")).chop(1);
-                QStringList controlStrings = parameter.split(",");
+            QString result;
+            expand(tokens, result);
+            return result;
+        }
 
-                if(commands.at(i).startsWith("%if")){
-                    if(!controlStrings.at(0).isEmpty() && controlStrings.size() > 1) {
-                        model.replace(commands.at(i), controlStrings.at(1));
-                    }
-                    else {
-                        model.remove(commands.at(i));
+        //! \brief Appends the net name of port \a name, or the sequence if not found.
+        void appendPort(const QString &name, QString &out)
+        {
+            foreach(Port *_port, m_component->ports()) {
+                if(_port->name() == name) {
+                    // Found the port, now look for its netlist name
+                    PortsNetlist::const_iterator it = m_netlist.constFind(_port);
+                    if(it != m_netlist.constEnd()) {
+                        out.append(it.value());
+                        return;
                     }
                 }
             }
 
-            // ************************************************************
-            // Now parse the non-cascadable commands (e.g. models), which may
-            // have a cascadable command as an argument (e.g. properties).
-            // ************************************************************
-            commands.clear();
-            re.setPattern("(%\\w+\{([\\w =+-\\\\(\\\\)\\n\\*\{}]+)})");
-            it = re.globalMatch(model);
-            while (it.hasNext()) {
-                QRegularExpressionMatch match = it.next();
-                commands << match.captured(0);
+            out.append("%port{" + name + "}");
+        }
+
+        //! \brief Adds the schematic of the current component for recursive netlists.
+        void appendSchematic()
+        {
+            QFileInfo info(m_component->filename());
+            appendUnique(m_schematics, m_libraryPath + "/" + info.completeBaseName() + ".xsch");
+        }
+
+        //! \brief Adds \a text to \a list, only if not already present.
+        static void appendUnique(QStringList &list, const QString &text)
+        {
+            if(!list.contains(text)) {
+                list << text;
             }
+        }
 
-            // For each command replace the parameter with the correct value
-            for(int i=0; i<commands.size(); i++){
+        const PortsNetlist &m_netlist;
+        const QString m_filePath;
 
-                // Extract the parameters, removing the comand (including the
-                // "{" and the last character "}")
-                QString parameter = commands.at(i);
-                parameter.remove(QRegularExpression("(%\\w+\{)")).chop(1);
+        Component *m_component;
+        QString m_libraryPath;
 
-                if(commands.at(i).startsWith("%model")){
+        QStringList m_models;
+        QStringList m_subcircuits;
+        QStringList m_directives;
+        QStringList m_schematics;
+    };
 
-                    // Models should be added to a temporal list to be included
-                    // only once at the end of the spice file.
-                    if(!modelsList.contains(parameter)) {
-                        modelsList << parameter;
-                    }
+    /*!
+     *  \brief Generate netlist
+     *
+     *  Iterate over all components, saving to a string the schematic netlist
+     *  according to the model provided as a set of rules. In order to do so,
+     *  the netlist topology must also be created, that is the connections
+     *  between the multiple components must be determined and numbered to be
+     *  used for the spice netlist. The set of rules used for generating the
+     *  netlist from the model is specified in \ref ModelsFormat. The models
+     *  are already parsed into a ModelTemplate when loading the library, so
+     *  here their tokens are only expanded into the netlist.
+     *
+     *  \sa generateNetlistTopology(), ModelTemplate, \ref ModelsFormat
+     */
+    QString FormatSpice::generateNetlist()
+    {
+        QList<QGraphicsItem*> items = graphicsScene()->items();
+        QList<Component*> components = filterItems<Component>(items);
 
-                    model.remove(commands.at(i));
+        // The file path may be used by the models, so if the schematic was
+        // saved elsewhere all the components must be generated again.
+        QString filePath = QFileInfo(m_schematicDocument->fileName()).absolutePath();
+        if(filePath != m_filePath) {
+            m_filePath = filePath;
+            m_components.clear();
+        }
 
+        // Update the nets only if there were connection changes, and
+        // generate again the components whose ports changed their net.
+        if(m_connectionsChanged) {
+            PortsNetlist netlist = generateNetlistTopology();
+            foreach(Component *c, components) {
+                foreach(Port *_port, c->ports()) {
+                    if(netlist.value(_port) != m_netlist.value(_port)) {
+                        m_changedComponents.insert(c);
+                        break;
+                    }
                 }
-                else if(commands.at(i).startsWith("%subcircuit")){
+            }
 
-                    // Subcircuits should be added to a temporal list to be included
-                    // only once at the end of the spice file.
-                    if(!subcircuitsList.contains(parameter)) {
-                        subcircuitsList << parameter;
-                    }
+            m_netlist = netlist;
+            m_connectionsChanged = false;
+        }
+
+        // Copy all the elements and properties in the schematic by
+        // iterating over all schematic components, reusing the netlist of
+        // those components not modified since the last netlist. Components
+        // no longer in the schematic are dropped.
+        QHash<Component*, ComponentNetlist> componentNetlists;
+        componentNetlists.reserve(components.size());
+        int sizeHint = 0;
+        foreach(Component *c, components) {
+            QHash<Component*, ComponentNetlist>::const_iterator it = m_components.constFind(c);
+            if(it == m_components.constEnd() || m_changedComponents.contains(c)) {
+                componentNetlists.insert(c, generateComponentNetlist(c));
+            }
+            else {
+                componentNetlists.insert(c, it.value());
+            }
+            sizeHint += componentNetlists.value(c).text.size() + 1;
+        }
+        m_components = componentNetlists;
+        m_changedComponents.clear();
 
-                    model.remove(commands.at(i));
+        // Start the document and write the header
+        QString retVal;
+        retVal.reserve(sizeHint + 64);
+        retVal.append("* Spice automatic export. Generated by Caneda.\n");
+        retVal.append("\n* Spice netlist.\n");
 
-                }
-                else if(commands.at(i).startsWith("%directive")){
+        QStringList modelsList;
+        QStringList subcircuitsList;
+        QStringList directivesList;
+        QStringList schematicsList;
 
-                    // Directives should be added to a temporal list to be included
-                    // only once at the end of the spice file.
-                    if(!directivesList.contains(parameter)) {
-                        directivesList << parameter;
-                    }
+        foreach(Component *c, components) {
+            const ComponentNetlist &netlist = m_components[c];
 
-                    model.remove(commands.at(i));
+            // Add the model and a newline to the file
+            retVal.append(netlist.text);
+            retVal.append("\n");
 
+            // Models, subcircuits, directives and schematics are included only once
+            foreach(const QString &model, netlist.models) {
+                if(!modelsList.contains(model)) {
+                    modelsList << model;
                 }
             }
-
-            // ************************************************************
-            // Now parse the generateNetlist command, which creates a
-            // temporal list of schematics needed for recursive netlists
-            // generation (for recursive simulations).
-            // ************************************************************
-            if(model.contains("%generateNetlist")){
-
-                QFileInfo info(c->filename());
-                QString baseName = info.completeBaseName();
-                QString path = libraryManager->library(c->library())->libraryPath();
-                QString schematic = path + "/" + baseName + ".xsch";
-
+            foreach(const QString &subcircuit, netlist.subcircuits) {
+                if(!subcircuitsList.contains(subcircuit)) {
+                    subcircuitsList << subcircuit;
+                }
+            }
+            foreach(const QString &directive, netlist.directives) {
+                if(!directivesList.contains(directive)) {
+                    directivesList << directive;
+                }
+            }
+            foreach(const QString &schematic, netlist.schematics) {
                 if(!schematicsList.contains(schematic)) {
                     schematicsList << schematic;
                 }
-
-                model.remove("%generateNetlist");
             }
-
-            // Add the model and a newline to the file
-            retVal.append(model + "\n");
         }
 
         // ************************************************************
         // Write the QStringLists that should be in the end of the
         // file (e.g. device models).
         // ************************************************************
+        QString definitions;
+
         // Append the spice models in modelsList
         if(!modelsList.isEmpty()) {
-            retVal.append("\n* Device models.\n");
+            definitions.append("\n* Device models.\n");
             for(int i=0; i<modelsList.size(); i++){
-                retVal.append(".model " + modelsList.at(i) + "\n");
+                definitions.append(".model " + modelsList.at(i) + "\n");
             }
         }
 
         // Append the spice subcircuits in subcircuitsList
         if(!subcircuitsList.isEmpty()) {
-            retVal.append("\n* Subcircuits models.\n");
+            definitions.append("\n* Subcircuits models.\n");
             for(int i=0; i<subcircuitsList.size(); i++){
-                retVal.append(".subckt " + subcircuitsList.at(i) + "\n"
-                              + ".ends" + "\n");
+                definitions.append(".subckt " + subcircuitsList.at(i) + "\n"
+                                   + ".ends" + "\n");
             }
         }
 
         // Append the spice directives in directivesList
         if(!directivesList.isEmpty()) {
-            retVal.append("\n* Spice directives.\n");
+            definitions.append("\n* Spice directives.\n");
             for(int i=0; i<directivesList.size(); i++){
-                retVal.append(directivesList.at(i) + "\n");
+                definitions.append(directivesList.at(i) + "\n");
             }
         }
 
+        // Remove multiple white spaces to clean up the file (the netlist of
+        // each component was already cleaned up when generated). The
+        // expression is compiled only once.
+        static const QRegularExpression re(" {2,}");
+        definitions.replace(re, " ");
+        retVal.append(definitions);
+
         // ************************************************************
         // Create the needed recursive netlist documents
         // ************************************************************
+        m_schematics = schematicsList;
         if(!schematicsList.isEmpty()) {
-            for(int i=0; i<schematicsList.size(); i++){
+            generateSchematicNetlists(schematicsList);
+        }
+
+        return retVal;
+    }
+
+    /*!
+     * \brief Generates the netlist of a single component.
+     *
+     * The spice model of the component, already parsed when loading the
+     * library, is expanded using the current nets (\a m_netlist).
+     *
+     * \sa generateNetlist(), ModelTemplate, \ref ModelsFormat
+     */
+    ComponentNetlist FormatSpice::generateComponentNetlist(Component *component)
+    {
+        LibraryManager *libraryManager = LibraryManager::instance();
+
+        // Get the spice model (multiple models may be available)
+        ModelTemplate model = component->modelTemplate("spice");
+
+        ModelExpander expander(m_netlist, m_filePath);
+        expander.setComponent(component, libraryManager->library(component->library())->libraryPath());
+
+        ComponentNetlist netlist;
+        netlist.text.reserve(model.sizeHint());
+        expander.expand(model.tokens(), netlist.text);
+
+        // Remove multiple white spaces to clean up the file. The expression
+        // is compiled only once, as this runs for every component.
+        static const QRegularExpression re(" {2,}");
+        netlist.text.replace(re, " ");
+
+        netlist.models = expander.models();
+        netlist.subcircuits = expander.subcircuits();
+        netlist.directives = expander.directives();
+        netlist.schematics = expander.schematics();
+
+        return netlist;
+    }
+
+    /*!
+     * \brief Marks \a component to be generated again on the next netlist.
+     *
+     * Inserting or removing a component also adds or removes nets, so in
+     * that case the nets must be extracted again too.
+     */
+    void FormatSpice::componentChanged(Component *component)
+    {
+        m_changedComponents.insert(component);
+
+        if(!m_components.contains(component) || component->scene() != graphicsScene()) {
+            m_connectionsChanged = true;
+        }
+    }
+
+    //! \brief Marks the nets to be extracted again on the next netlist.
+    void FormatSpice::connectionsChanged()
+    {
+        m_connectionsChanged = true;
+    }
+
+    /*!
+     * \brief Helper class to hash the contents of a schematic file in a
+     * different thread.
+     *
+     * \sa FormatSpice::generateSchematicNetlists()
+     */
+    class SchematicHasher : public QRunnable
+    {
+    public:
+        explicit SchematicHasher(const QString &schematic) : m_schematic(schematic)
+        {
+            setAutoDelete(false);
+        }
+
+        void run()
+        {
+            QFile file(m_schematic);
+            if(file.open(QIODevice::ReadOnly)) {
+                QCryptographicHash hash(QCryptographicHash::Sha1);
+                hash.addData(&file);
+                m_hash = hash.result();
+            }
+        }
+
+        QString schematic() const { return m_schematic; }
+        QByteArray hash() const { return m_hash; }
+
+    private:
+        QString m_schematic;
+        QByteArray m_hash;
+    };
+
+    /*!
+     * \brief Generates the netlists of the schematics used in a hierarchy.
+     *
+     * The schematics (and all the schematics they need in their turn, as
+     * known from the last time they were generated) are hashed concurrently.
+     * Only those netlists whose schematic, or any of its children, changed
+     * since they were last generated are created again. As loading a
+     * schematic creates graphics items and uses the library caches, the
+     * stale netlists themselves are generated in the current thread.
+     *
+     * \param schematics Schematic file names whose netlists are needed.
+     *
+     * \sa generateNetlist(), netlistCache()
+     */
+    void FormatSpice::generateSchematicNetlists(const QStringList &schematics)
+    {
+        QHash<QString, NetlistCacheEntry> &cache = netlistCache();
+
+        // Collect all the known schematics of the hierarchy
+        QStringList pending = schematics;
+        QSet<QString> hierarchy;
+        while(!pending.isEmpty()) {
+            QString schematic = pending.takeLast();
+            if(!hierarchy.contains(schematic)) {
+                hierarchy.insert(schematic);
+                pending << cache.value(schematic).schematics;
+            }
+        }
+
+        // Hash all the schematic files concurrently
+        QList<SchematicHasher*> hashers;
+        QThreadPool pool;
+        foreach(const QString &schematic, hierarchy) {
+            hashers << new SchematicHasher(schematic);
+            pool.start(hashers.last());
+        }
+        pool.waitForDone();
+
+        QHash<QString, QByteArray> hashes;
+        foreach(SchematicHasher *hasher, hashers) {
+            hashes.insert(hasher->schematic(), hasher->hash());
+        }
+        qDeleteAll(hashers);
+
+        // Generate only the netlists out of date
+        foreach(const QString &schematic, schematics) {
+            QSet<QString> visited;
+            if(isNetlistUpToDate(schematic, hashes, visited)) {
+                continue;
+            }
 
-                SchematicDocument *document = new SchematicDocument();
-                document->setFileName(schematicsList.at(i));
+            SchematicDocument *document = new SchematicDocument();
+            document->setFileName(schematic);
 
-                if(document->load()) {
-                    // Export the schematic to a spice netlist
-                    FormatSpice *format = new FormatSpice(document);
-                    format->save();
+            if(document->load()) {
+                // Export the schematic to a spice netlist
+                FormatSpice *format = new FormatSpice(document);
+                if(format->save() && !hashes.value(schematic).isEmpty()) {
+                    NetlistCacheEntry entry;
+                    entry.hash = hashes.value(schematic);
+                    entry.schematics = format->m_schematics;
+                    entry.libraryGeneration = LibraryManager::instance()->generation();
+                    entry.simulator = Settings::instance()->currentValue("sim/simulationEngine").toString();
+                    cache.insert(schematic, entry);
                 }
+            }
+
+            delete document;
+        }
+    }
+
+    /*!
+     * \brief Returns true if the netlist of \a schematic needs no update.
+     *
+     * A netlist is up to date if it exists, was generated from a schematic
+     * with the same contents, with the same libraries and for the same
+     * simulator, and all the netlists of the schematics it needs are also
+     * up to date.
+     *
+     * \param schematic Schematic file name.
+     * \param hashes Current hashes of the schematic files.
+     * \param visited Schematics already checked, to avoid checking twice.
+     */
+    bool FormatSpice::isNetlistUpToDate(const QString &schematic,
+                                        const QHash<QString, QByteArray> &hashes,
+                                        QSet<QString> &visited)
+    {
+        if(visited.contains(schematic)) {
+            return true;
+        }
+        visited.insert(schematic);
+
+        QHash<QString, NetlistCacheEntry>::const_iterator it = netlistCache().constFind(schematic);
+        if(it == netlistCache().constEnd() || it.value().hash != hashes.value(schematic) ||
+                it.value().libraryGeneration != LibraryManager::instance()->generation() ||
+                it.value().simulator != Settings::instance()->currentValue("sim/simulationEngine").toString() ||
+                !QFile::exists(netlistFileName(schematic))) {
+            return false;
+        }
 
-                delete document;
+        foreach(const QString &child, it.value().schematics) {
+            if(!isNetlistUpToDate(child, hashes, visited)) {
+                return false;
             }
         }
 
-        // Remove multiple white spaces to clean up the file
-        QRegularExpression re(" {2,}");
-        retVal.replace(re, " ");
+        return true;
+    }
 
-        return retVal;
+    //! \brief Returns the cache of the netlists generated from schematics.
+    QHash<QString, NetlistCacheEntry>& FormatSpice::netlistCache()
+    {
+        static QHash<QString, NetlistCacheEntry> cache;
+        return cache;
     }
 
     /*!
@@ -1620,7 +1894,14 @@ namespace Caneda
      *  to create a netlist node even on those places not connected by
      *  wires (for example when connecting two components together).
      *
-     *  \sa saveComponents(), Port::getEquipotentialPorts()
+     *  The nets are extracted all at once by Port::equipotentialNets(), in
+     *  near linear time in the number of ports. Each net keeps the number it
+     *  had in the previous netlist (if any of its ports had one not already
+     *  taken), so that a local change of the connections only renames the
+     *  nets involved, and only the components on those nets must be
+     *  generated again.
+     *
+     *  \sa saveComponents(), Port::equipotentialNets()
      */
     PortsNetlist FormatSpice::generateNetlistTopology()
     {
@@ -1635,406 +1916,1092 @@ namespace Caneda
             ports << i->ports();
         }
 
-        int equiId = 1;
-        PortsNetlist netlist;
-        QList<Port*> parsedPorts;
+        QHash<Port*, int> nets = Port::equipotentialNets(ports);
 
-        foreach(Port *p, ports) {
-            if(parsedPorts.contains(p)) {
-                continue;
+        // Reuse the numbers of the previous netlist where possible
+        QHash<int, int> numbers;
+        QSet<int> usedNumbers;
+        int lastNumber = 0;
+        for(QHash<Port*, int>::const_iterator it = nets.constBegin(); it != nets.constEnd(); ++it) {
+            const int previous = m_netNumbers.value(it.key(), 0);
+            if(previous > 0 && !numbers.contains(it.value()) && !usedNumbers.contains(previous)) {
+                numbers.insert(it.value(), previous);
+                usedNumbers.insert(previous);
+                lastNumber = qMax(lastNumber, previous);
             }
+        }
 
-            QList<Port*> equi;
-            p->getEquipotentialPorts(equi);
-            foreach(Port *_port, equi) {
-                netlist.append(qMakePair(_port, QString::number(equiId)));
+        // New nets are numbered after the existing ones
+        for(QHash<Port*, int>::iterator it = nets.begin(); it != nets.end(); ++it) {
+            QHash<int, int>::const_iterator number = numbers.constFind(it.value());
+            if(number == numbers.constEnd()) {
+                number = numbers.insert(it.value(), ++lastNumber);
             }
-
-            equiId++;
-            parsedPorts += equi;
+            it.value() = number.value();
         }
+        m_netNumbers = nets;
+
+        QHash<int, QString> labels = netLabels(nets);
 
-        replacePortNames(&netlist);
+        // Name each net after its PortSymbol label, or its number if none
+        PortsNetlist netlist;
+        netlist.reserve(nets.size());
+        for(QHash<Port*, int>::const_iterator it = nets.constBegin(); it != nets.constEnd(); ++it) {
+            QHash<int, QString>::const_iterator label = labels.constFind(it.value());
+            netlist.insert(it.key(), label != labels.constEnd() ? label.value() : QString::number(it.value()));
+        }
 
         return netlist;
     }
 
     /*!
-     * \brief Replace net names in the netlist by those specified by
-     * portSymbols.
+     * \brief Returns the net names specified by portSymbols.
      *
-     * Iterate over all nets in the netlist, replacing those names that
-     * correspond to the ones selected by the user using PortSymbols.
-     * Take special care of the ground nets, that must be named "0" to
-     * be complatible with the spice netlist format.
+     * Iterate over all PortSymbols, looking up the net of their port, and
+     * map that net to the name selected by the user. Take special care of
+     * the ground nets, that must be named "0" to be complatible with the
+     * spice netlist format. If several PortSymbols share the same net, the
+     * last one determines its name.
      *
-     * \param netlist Netlist which is to be used in PortSymbol names
-     * replacement.
+     * \param nets Net number of each port, as returned by
+     * Port::equipotentialNets().
+     * \return Name of each net with a PortSymbol, indexed by net number.
      *
      * \sa PortSymbol, generateNetlistTopology()
      */
-    void FormatSpice::replacePortNames(PortsNetlist *netlist)
+    QHash<int, QString> FormatSpice::netLabels(const QHash<Port*, int> &nets)
     {
         QList<QGraphicsItem*> items = graphicsScene()->items();
         QList<PortSymbol*> portSymbols = filterItems<PortSymbol>(items);
 
+        QHash<int, QString> labels;
+
         // Iterate over all PortSymbols
         foreach(PortSymbol *p, portSymbols) {
 
-            // Given the port, look for its netlist name
-            QString netName;
-            for(int i = 0; i < netlist->size(); ++i) {
-                if(netlist->at(i).first == p->port()) {
-                    netName = netlist->at(i).second;
-                }
+            // Given the port, look for its net
+            QHash<Port*, int>::const_iterator it = nets.constFind(p->port());
+            if(it == nets.constEnd()) {
+                continue;
             }
 
-            // Given the netlist name, rename all occurencies with the new name
-            for(int i = 0; i < netlist->size(); ++i) {
-                if(netlist->at(i).second == netName) {
-                    if(p->label().toLower() == "ground" || p->label().toLower() == "gnd") {
-                        netlist->replace(i, qMakePair(netlist->at(i).first, QString::number(0)));
-                    }
-                    else {
-                        netlist->replace(i, qMakePair(netlist->at(i).first, p->label()));
-                    }
-                }
+            if(p->label().toLower() == "ground" || p->label().toLower() == "gnd") {
+                labels.insert(it.value(), QString::number(0));
+            }
+            else {
+                labels.insert(it.value(), p->label());
             }
         }
+
+        return labels;
     }
 
 
     /*************************************************************************
-     *                         FormatRawSimulation                           *
+     *                           RawAsciiParser                              *
      *************************************************************************/
-    //! \brief Constructor.
-    FormatRawSimulation::FormatRawSimulation(SimulationDocument *document) :
-        QObject(document),
-        m_simulationDocument(document)
-    {
-    }
-
-    //! \brief Load the waveform file indicated by \a filename.
-    bool FormatRawSimulation::load()
+    /*!
+     * \brief Constructor.
+     *
+     * \param begin Beginning of the chunk, at the start of a data point.
+     * \param end End of the chunk. Points starting after this position
+     * belong to the next chunk.
+     * \param dataEnd End of the whole data section.
+     * \param nvars Number of variables of each point.
+     * \param firstPoint Index of the point stored first in the output arrays.
+     * \param npoints Number of points of the output arrays.
+     * \param real True if the values are real, false if complex.
+     * \param magnitude Output arrays (one for each variable) for the real
+     * values, or for the complex magnitude in dB.
+     * \param phase Output arrays (one for each variable) for the complex
+     * phase. Not used for real values.
+     */
+    RawAsciiParser::RawAsciiParser(const char *begin, const char *end,
+                                   const char *dataEnd, int nvars, int firstPoint,
+                                   int npoints, bool real, double **magnitude,
+                                   double **phase) :
+        m_begin(begin),
+        m_end(end),
+        m_dataEnd(dataEnd),
+        m_nvars(nvars),
+        m_firstPoint(firstPoint),
+        m_npoints(npoints),
+        m_real(real),
+        m_magnitude(magnitude),
+        m_phase(phase),
+        m_lastPoint(-1)
     {
-        ChartScene *scene = chartScene();
-        if(!scene) {
-            return false;
-        }
-
-        QString filename = m_simulationDocument->fileName();
-        QFile file(filename);
-        if(!file.open(QIODevice::ReadOnly)) {
-            QMessageBox::critical(0, QObject::tr("Error"),
-                    QObject::tr("Cannot load document ") + filename);
-            return false;
-        }
-
-        QTextStream in(&file);
-        parseFile(&in);  // Parse the raw file
-        file.close();
-
-        return true;
+        setAutoDelete(false);
     }
 
     /*!
-     * \brief Parse the raw file
-     *
-     * Parse the raw file. First check the header of the file and then call
-     * the parseAsciiData() or parseBinaryData() method depending on the
-     * type of file.
+     * \brief Parses the points of the chunk.
      *
-     * \sa parseAsciiData(), parseBinaryData()
-     *
-     * \todo There can be more than one plot set. This should be considered.
+     * Each point is composed by its index, followed by the value of each
+     * variable (complex values have their real and imaginary part separated
+     * by a comma). Complex values are collected into a small block with the
+     * same layout of a binary raw file, and converted a block at a time by
+     * complexToPolar().
      */
-    void FormatRawSimulation::parseFile(QTextStream *file)
+    void RawAsciiParser::run()
     {
-        int nvars = 0;     // Number of variables
-        int npoints = 0;   // Number of points in the simulation
-        bool real = true;  // Transient/AC simulation: real = transient / false = ac (complex numbers)
+        // Block of complex values waiting for conversion
+        const int blockPoints = 64;
+        QVector<double> block(m_real ? 0 : blockPoints * 2 * m_nvars);
+        int blockFirst = 0;
+        int blockCount = 0;
 
-        QString line = file->readLine();
+        const char *pos = m_begin;
+        while(pos < m_end) {
 
-        while(!line.isNull()) {
+            // Skip the blanks before the point index
+            while(pos < m_end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) {
+                ++pos;
+            }
+            if(pos >= m_end || *pos < '0' || *pos > '9') {
+                break;
+            }
 
-            line = line.toLower();  // Don't care the case of the entry
-            QStringList tok = line.split(":");
-            QString keyword = tok.at(0);
+            // Read the point index
+            int index = 0;
+            while(pos < m_end && *pos >= '0' && *pos <= '9') {
+                index = index*10 + (*pos - '0');
+                ++pos;
+            }
 
-            // Ignore the following keywords: title, date, plotname
-            if( keyword == "flags" ) {
-                if(tok.at(1) == " real") {
-                    real = true;
-                }
-                else if(tok.at(1) == " complex") {
-                    real = false;
+            const bool valid = index >= m_firstPoint && index < m_firstPoint + m_npoints;
+            if(valid && index > m_lastPoint) {
+                m_lastPoint = index;
+            }
+
+            // Flush the pending complex values if this point does not follow them
+            if(!m_real && blockCount > 0 && (index != blockFirst + blockCount || blockCount == blockPoints)) {
+                flushComplex(block.constData(), blockFirst, blockCount);
+                blockCount = 0;
+            }
+            if(!m_real && blockCount == 0) {
+                blockFirst = index;
+            }
+
+            // Read the values of all variables. The point may continue after
+            // the chunk end, so the whole data section is used as the limit.
+            double *row = m_real ? 0 : block.data() + blockCount * 2 * m_nvars;
+            for(int j = 0; j < m_nvars; j++){
+                double real = 0;
+                double imaginary = 0;
+
+                parseDouble(pos, m_dataEnd, &real);
+                if(!m_real) {
+                    if(pos < m_dataEnd && *pos == ',') {
+                        ++pos;
+                    }
+                    parseDouble(pos, m_dataEnd, &imaginary);
+
+                    row[2*j] = real;
+                    row[2*j + 1] = imaginary;
                 }
-                else {
-                    qDebug() << "Warning: unknown flag: " + tok.at(1);
+                else if(valid) {
+                    m_magnitude[j][index - m_firstPoint] = real;
                 }
             }
-            else if( keyword == "no. variables") {
-                nvars = tok.at(1).toInt();
+
+            if(!m_real && valid) {
+                ++blockCount;
             }
-            else if( keyword == "no. points") {
-                npoints = tok.at(1).toInt();
+        }
+
+        if(blockCount > 0) {
+            flushComplex(block.constData(), blockFirst, blockCount);
+        }
+    }
+
+    /*!
+     * \brief Converts a block of \a count consecutive complex points,
+     * starting at point index \a first, into the output arrays.
+     *
+     * The first variable is the frequency base for the rest of the curves,
+     * so only its real part is kept.
+     */
+    void RawAsciiParser::flushComplex(const double *block, int first, int count)
+    {
+        const uchar *src = reinterpret_cast<const uchar*>(block);
+        const int stride = 2 * m_nvars * sizeof(double);
+        first -= m_firstPoint;
+
+        for(int i = 0; i < count; i++){
+            m_magnitude[0][first + i] = block[i * 2 * m_nvars];
+        }
+
+        for(int j = 1; j < m_nvars; j++){
+            complexToPolar(src + 2*j*sizeof(double), stride,
+                           m_magnitude[j] + first, m_phase[j] + first, count);
+        }
+    }
+
+    /*!
+     * \brief Returns the start of the first data point at or after \a pos.
+     *
+     * Data points start on a line beginning with the point index, while the
+     * rest of the values of the point are in lines beginning with a tab.
+     */
+    const char* RawAsciiParser::nextPoint(const char *pos, const char *end)
+    {
+        while(pos < end) {
+            const char *lineEnd = static_cast<const char*>(memchr(pos, '\n', end - pos));
+            if(!lineEnd) {
+                return end;
             }
-            else if( keyword == "variables") {
 
-                for(int i = 0; i < nvars; i++) {
-                    line = file->readLine();
+            pos = lineEnd + 1;
+            if(pos < end && *pos != '\t') {
+                return pos;
+            }
+        }
 
-                    tok = line.split("\t", QString::SkipEmptyParts);
-                    if(tok.size() >= 3){
-                        // Number property not used: number = tok.at(0)
+        return end;
+    }
 
-                        // Create a new curve, and add it to the list
-                        if(real) {
-                            // If dealing with real numbers, create an array only for the magnitude and use the provided curve types
-                            ChartSeries *curve = new ChartSeries(tok.at(1));  // tok.at(1) = name
-                            curve->setType(tok.at(2));  // tok.at(2) = type of curve (voltage, current, etc)
-                            plotCurves.append(curve);   // Append new curve to the list
-                        }
-                        else {
-                            // If dealing with complex numbers, create an array for the magnitude and another one for the phase
-                            ChartSeries *curve = new ChartSeries("Mag(" + tok.at(1) + ")");       // tok.at(1) = name
-                            ChartSeries *curvePhase = new ChartSeries("Phase(" + tok.at(1) + ")");  // tok.at(1) = name
-                            curve->setType("magnitude");         // type of curve (magnitude, phase, etc)
-                            curvePhase->setType("phase");        // type of curve (magnitude, phase, etc)
-                            plotCurves.append(curve);            // Append new curve to the list
-                            plotCurvesPhase.append(curvePhase);  // Append new curve to the list
-                        }
+    /*!
+     * \brief Returns the end of the data section starting at \a begin.
+     *
+     * The data section ends at the end of the file, or at the first line
+     * beginning with a letter (the header of a following plot).
+     */
+    const char* RawAsciiParser::dataEnd(const char *begin, const char *end)
+    {
+        const char *pos = begin;
+        while(pos < end) {
+            const char *lineEnd = static_cast<const char*>(memchr(pos, '\n', end - pos));
+            if(!lineEnd) {
+                return end;
+            }
+
+            pos = lineEnd + 1;
+            if(pos < end && ((*pos >= 'a' && *pos <= 'z') || (*pos >= 'A' && *pos <= 'Z'))) {
+                return pos;
+            }
+        }
+
+        return end;
+    }
+
+    /*!
+     * \brief Returns the start of the last data point in the range from
+     * \a begin to \a end, or \a end if there is none.
+     *
+     * While a simulation is running, the last point of the file may be only
+     * partially written, so the data is read only up to this position.
+     */
+    const char* RawAsciiParser::lastPointStart(const char *begin, const char *end)
+    {
+        const char *pos = end;
+        while(pos > begin) {
+            --pos;
+            if((pos == begin || *(pos - 1) == '\n') &&
+                    *pos != '\t' && *pos != '\r' && *pos != '\n') {
+                return pos;
+            }
+        }
+
+        return end;
+    }
+
+    /*!
+     * \brief Parses a floating point number in place.
+     *
+     * Leading blanks are skipped, and \a pos is left just after the number.
+     * The digits of the mantissa are accumulated into an integer. If the
+     * mantissa fits in the 53 bits of a double and the exponent is at most
+     * 22 (so that the power of ten is also exact), the number is a single
+     * multiplication or division of two exact doubles, and therefore
+     * correctly rounded (Clinger's fast path). This covers the numbers
+     * written by spice simulators without allocating any string. Other
+     * numbers (as for example those with more digits, nan or inf) fall back
+     * to QByteArray::toDouble().
+     *
+     * \return True if a number was found, false otherwise.
+     */
+    bool RawAsciiParser::parseDouble(const char *&pos, const char *end, double *value)
+    {
+        static const double powersOfTen[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+            1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+            1e20, 1e21, 1e22
+        };
+        static const quint64 maxExactMantissa = Q_UINT64_C(1) << 53;
+
+        while(pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) {
+            ++pos;
+        }
+
+        const char *start = pos;
+
+        bool negative = false;
+        if(pos < end && (*pos == '-' || *pos == '+')) {
+            negative = (*pos == '-');
+            ++pos;
+        }
 
+        quint64 mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool found = false;
+
+        // Integer part
+        while(pos < end && *pos >= '0' && *pos <= '9') {
+            if(digits < 19) {
+                mantissa = mantissa*10 + (*pos - '0');
+                if(mantissa) {
+                    ++digits;
+                }
+            }
+            else {
+                ++exponent;
+            }
+            found = true;
+            ++pos;
+        }
+
+        // Fractional part
+        if(pos < end && *pos == '.') {
+            ++pos;
+            while(pos < end && *pos >= '0' && *pos <= '9') {
+                if(digits < 19) {
+                    mantissa = mantissa*10 + (*pos - '0');
+                    if(mantissa) {
+                        ++digits;
                     }
-                    else {
-                        qDebug() << "List of variables too short.";
+                    --exponent;
+                }
+                found = true;
+                ++pos;
+            }
+        }
+
+        if(!found) {
+            // Not a plain number, let Qt handle it (nan, inf, etc)
+            while(pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' &&
+                    *pos != '\n' && *pos != ',') {
+                ++pos;
+            }
+
+            bool ok = false;
+            *value = QByteArray(start, pos - start).toDouble(&ok);
+            return ok;
+        }
+
+        // Exponent
+        if(pos < end && (*pos == 'e' || *pos == 'E')) {
+            const char *expStart = pos;
+            ++pos;
+
+            bool negativeExp = false;
+            if(pos < end && (*pos == '-' || *pos == '+')) {
+                negativeExp = (*pos == '-');
+                ++pos;
+            }
+
+            if(pos < end && *pos >= '0' && *pos <= '9') {
+                int exp = 0;
+                while(pos < end && *pos >= '0' && *pos <= '9') {
+                    if(exp < 10000) {
+                        exp = exp*10 + (*pos - '0');
                     }
+                    ++pos;
                 }
+                exponent += negativeExp ? -exp : exp;
             }
-            else if( keyword == "values" ) {
-                parseAsciiData(file, nvars, npoints, real);  // Read the data itself
+            else {
+                pos = expStart;  // Not an exponent
             }
-            else if( keyword == "binary") {
-                parseBinaryData(file, nvars, npoints, real);  // Read the data itself
+        }
+
+        const int absExp = exponent < 0 ? -exponent : exponent;
+        if(mantissa == 0 || (mantissa <= maxExactMantissa && absExp <= 22)) {
+            double result = double(mantissa);
+            if(mantissa != 0 && exponent != 0) {
+                result = exponent < 0 ? result / powersOfTen[absExp] : result * powersOfTen[absExp];
             }
 
-            // Read the next line
-            line = file->readLine();
+            *value = negative ? -result : result;
+            return true;
         }
+
+        bool ok = false;
+        *value = QByteArray(start, pos - start).toDouble(&ok);
+        return ok;
+    }
+
+
+    /*************************************************************************
+     *                         FormatRawSimulation                           *
+     *************************************************************************/
+    //! \brief Constructor.
+    FormatRawSimulation::FormatRawSimulation(SimulationDocument *document) :
+        QObject(document),
+        m_simulationDocument(document),
+        m_indexPos(0),
+        m_following(false),
+        m_followTimer(0)
+    {
     }
 
     /*!
-     * \brief Read the data in Ascii format implementation
+     * \brief Load the waveform file indicated by \a filename.
+     *
+     * The file is first indexed (see parseFile()), and then only the data of
+     * the default plot is read. The data of the rest of the plots is read
+     * only when the plot is selected by the user (see loadPlot()).
+     */
+    bool FormatRawSimulation::load()
+    {
+        ChartScene *scene = chartScene();
+        if(!scene) {
+            return false;
+        }
+
+        QString filename = m_simulationDocument->fileName();
+        QFile file(filename);
+        if(!file.open(QIODevice::ReadOnly) ||
+                !scene->sampleStore()->mapFile(filename)) {
+            QMessageBox::critical(0, QObject::tr("Error"),
+                    QObject::tr("Cannot load document ") + filename);
+            return false;
+        }
+
+        QTextStream in(&file);
+        parseFile(&in);  // Index the raw file
+        file.close();
+
+        // Show the first plot with more than one point (skipping, for
+        // example, operating point plots), or the first one if none.
+        int current = 0;
+        for(int i = 0; i < m_plots.size(); i++) {
+            if(m_plots.at(i).npoints > 1) {
+                current = i;
+                break;
+            }
+        }
+
+        loadPlot(current);
+        scene->setCurrentPlot(current);
+
+        return true;
+    }
+
+    /*!
+     * \brief Starts following the raw file, while the simulator is still
+     * writing it.
      *
-     * Read the data in Ascii format implementation. Here we use a QTextStream
-     * object to serially read text data from the file. QTextStream assumes
-     * text data and "translates it" to text using the default codec (utf-8,
-     * iso-8859-1, etc), and interpreting special characters as for example
-     * newlines.
+     * The file is polled periodically, and the new points of the plot being
+     * written are appended to its curves, without reading again the points
+     * already loaded. New plots are indexed as soon as their header is
+     * complete, and displayed as they are the ones being simulated.
      *
-     * \sa parseBinaryData(), parseFile()
+     * \sa stopFollowing()
      */
-    void FormatRawSimulation::parseAsciiData(QTextStream *file, const int nvars, const int npoints, const bool real)
+    void FormatRawSimulation::startFollowing()
     {
-        // Create the arrays to deal with the data
-        QList<double*> dataSamples;               // List of curve's magnitude data. Once filled, used to set data in plotCurves.
-        QList<double*> dataSamplesPhase;          // List of curve's phase data. Used for complex numbers. Once filled, used to set data in plotCurves.
+        if(!m_followTimer) {
+            m_followTimer = new QTimer(this);
+            connect(m_followTimer, SIGNAL(timeout()), this, SLOT(followFile()));
+        }
 
-        for(int i = 0; i < nvars; i++) {
-            if(real) {
+        m_following = true;
+        m_followTimer->start(500);
+
+        // Display the plot being written
+        if(!m_plots.isEmpty() && !m_plots.last().complete) {
+            m_simulationDocument->setCurrentPlot(m_plots.size() - 1);
+        }
+    }
+
+    /*!
+     * \brief Stops following the raw file, once the simulator has finished
+     * writing it.
+     *
+     * The data written since the last poll is read, including the final
+     * number of points of the last plot.
+     *
+     * \sa startFollowing()
+     */
+    void FormatRawSimulation::stopFollowing()
+    {
+        if(!m_following) {
+            return;
+        }
+
+        m_followTimer->stop();
+        m_following = false;
+
+        updateFile();
+    }
+
+    //! \brief Reads the new data of the followed file, if the file grew.
+    void FormatRawSimulation::followFile()
+    {
+        QFileInfo info(m_simulationDocument->fileName());
+        if(info.size() != chartScene()->sampleStore()->mappedSize()) {
+            updateFile();
+        }
+    }
+
+    /*!
+     * \brief Reads the data appended to the file since the last update.
+     *
+     * The file is mapped again with its new size. Then, the new points of
+     * the plot being written are read, and any plots following it are
+     * indexed, starting at the end of the last complete plot.
+     *
+     * \sa startFollowing(), parseFile()
+     */
+    void FormatRawSimulation::updateFile()
+    {
+        ChartScene *scene = chartScene();
+        if(!scene) {
+            return;
+        }
+
+        QString filename = m_simulationDocument->fileName();
+        ChartSampleStorePtr store = scene->sampleStore();
+        if(QFileInfo(filename).size() != store->mappedSize() && !store->mapFile(filename)) {
+            return;
+        }
+
+        // Read the new points of the plot being written
+        if(!m_plots.isEmpty() && !m_plots.last().complete) {
+            const int plot = m_plots.size() - 1;
+            updatePlotSize(plot);
+
+            const RawPlot &header = m_plots.at(plot);
+            if(header.loaded && header.nvars > 0) {
+                if(header.binary) {
+                    parseBinaryData(plot);
+                }
+                else {
+                    parseAsciiData(plot);
+                }
+
+                if(plot == scene->currentPlot()) {
+                    scene->updateSamples();
+                }
+            }
+
+            if(!header.complete) {
+                return;
+            }
+
+            m_indexPos = header.offset + header.size;
+        }
+
+        // Index the plots written after the last complete one
+        const int count = m_plots.size();
+
+        QFile file(filename);
+        if(!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+
+        QTextStream in(&file);
+        in.seek(m_indexPos);
+        parseFile(&in);
+        file.close();
+
+        if(m_plots.size() > count) {
+            m_simulationDocument->setCurrentPlot(m_plots.size() - 1);
+        }
+    }
+
+    /*!
+     * \brief Read the data of \a plot, if not previously read.
+     *
+     * Create the curves of the plot, and then call the parseAsciiData() or
+     * parseBinaryData() method depending on the type of data.
+     *
+     * \return True on success, false otherwise.
+     * \sa load(), parseFile()
+     */
+    bool FormatRawSimulation::loadPlot(int plot)
+    {
+        if(plot < 0 || plot >= m_plots.size()) {
+            return false;
+        }
+
+        RawPlot &header = m_plots[plot];
+        if(header.loaded) {
+            return true;
+        }
+
+        plotCurves.clear();
+        plotCurvesPhase.clear();
+
+        for(int i = 0; i < header.nvars; i++) {
+            // Create a new curve, and add it to the list
+            if(header.real) {
                 // If dealing with real numbers, create an array only for the magnitude and use the provided curve types
-                double *data = new double[npoints];  // Create new dataset
-                dataSamples.append(data);  // Append new data set to the list
+                ChartSeries *curve = new ChartSeries(header.variables.at(i));
+                curve->setType(header.types.at(i));  // type of curve (voltage, current, etc)
+                plotCurves.append(curve);   // Append new curve to the list
             }
             else {
                 // If dealing with complex numbers, create an array for the magnitude and another one for the phase
-                double *data = new double[npoints];  // Create new dataset
-                double *dataPhase = new double[npoints];  // Create new dataset
-                dataSamples.append(data);  // Append new data set to the list
-                dataSamplesPhase.append(dataPhase);  // Append new data set to the list
+                ChartSeries *curve = new ChartSeries("Mag(" + header.variables.at(i) + ")");
+                ChartSeries *curvePhase = new ChartSeries("Phase(" + header.variables.at(i) + ")");
+                curve->setType("magnitude");         // type of curve (magnitude, phase, etc)
+                curvePhase->setType("phase");        // type of curve (magnitude, phase, etc)
+                plotCurves.append(curve);            // Append new curve to the list
+                plotCurvesPhase.append(curvePhase);  // Append new curve to the list
             }
         }
 
-        // Read the data
-        if(real) {
-            // The data is of type real
-            for(int i = 0; i < npoints; i++){
-                for(int j = 0; j < nvars; j++){
-                    QString line = file->readLine();
-                    dataSamples[j][i] = line.split("\t").last().toDouble();
-                }
+        if(header.nvars > 0) {
+            if(header.binary) {
+                parseBinaryData(plot);  // Read the data itself
+            }
+            else {
+                parseAsciiData(plot);  // Read the data itself
             }
 
-            // Avoid the first var, as it is the time base for the rest
-            // of the curves.
-            for(int i = 1; i < nvars; i++){
-                // Copy the data into the curves
-                plotCurves[i]->setSamples(dataSamples[0], dataSamples[i], npoints);
-                // Add the curve to the scene
-                chartScene()->addItem(plotCurves[i]);
+            // The first var is the time/frequency base, and is not
+            // added to the scene as a curve.
+            delete plotCurves.first();
+            if(!plotCurvesPhase.isEmpty()) {
+                delete plotCurvesPhase.first();
             }
         }
-        else {
-            // The data is of type complex
-            double real = 0;
-            double imaginary = 0;
-            double magnitude = 0;
-            double phase = 0;
 
-            // Read the data values, converting the complex data into
-            // magnitude and phase data.
-            for(int i = 0; i < npoints; i++){
-                for(int j = 0; j < nvars; j++){
-                    QString line = file->readLine();
-                    QStringList tok = line.split("\t");
-                    line = tok.last();  // Get the complex numeric data
-                    tok = line.split(",");  // Split real and imaginary part
+        plotCurves.clear();
+        plotCurvesPhase.clear();
 
-                    real = tok.first().toDouble();  // Get the real part
-                    imaginary = tok.last().toDouble();  // Get the imaginary part
+        header.loaded = true;
+        return true;
+    }
 
-                    magnitude = qSqrt(real*real + imaginary*imaginary);  // Calculate the magnitude part
-                    phase = qAtan(imaginary/real) * 180/M_PI;  // Calculate the phase part
+    /*!
+     * \brief Index the raw file
+     *
+     * Index the raw file, reading the header of each plot in the file and
+     * recording the position and size of its data, without reading the data
+     * itself. A raw file may contain several plots, for example an operating
+     * point followed by a transient and an ac analysis, or one plot for each
+     * .alter or .step run. A new plot is added to the scene for each of them.
+     *
+     * \sa loadPlot(), parseAsciiData(), parseBinaryData()
+     */
+    void FormatRawSimulation::parseFile(QTextStream *file)
+    {
+        RawPlot header;  // Header of the plot being read
 
-                    dataSamples[j][i] = magnitude;
-                    dataSamplesPhase[j][i] = phase;
+        qint64 lineStart = file->pos();
+        QString line = file->readLine();
+
+        while(!line.isNull()) {
+
+            // Don't care the case of the keyword
+            QString keyword = line.section(":", 0, 0).toLower();
+            QString value = line.section(":", 1).trimmed();
+
+            // Ignore the following keywords: title, date
+            if( keyword == "plotname" ) {
+                header.name = value;
+            }
+            else if( keyword == "flags" ) {
+                if(value.toLower().startsWith("real")) {
+                    header.real = true;  // Transient simulation (real numbers)
                 }
+                else if(value.toLower().startsWith("complex")) {
+                    header.real = false;  // AC simulation (complex numbers)
+                }
+                else {
+                    qDebug() << "Warning: unknown flag: " + value;
+                }
+            }
+            else if( keyword == "no. variables") {
+                header.nvars = value.toInt();
             }
+            else if( keyword == "no. points") {
+                // The number itself is read by updatePlotSize(), as it may
+                // change while the plot is being written.
+                header.pointsPos = lineStart;
+            }
+            else if( keyword == "variables") {
 
-            // Convert the magnitude values into dB ( dB = 20*log10(V) ).
-            // Avoid the first var (var=0), as it is the frequency base
-            // for the rest of the curves.
-            for(int i = 0; i < npoints; i++){
-                for(int j = 1; j < nvars; j++){
-                    dataSamples[j][i] = 20*log10(dataSamples[j][i]);
+                for(int i = 0; i < header.nvars; i++) {
+                    line = file->readLine();
+
+                    QStringList tok = line.split("\t", QString::SkipEmptyParts);
+                    if(tok.size() >= 3){
+                        // Number property not used: number = tok.at(0)
+                        header.variables.append(tok.at(1));  // tok.at(1) = name
+                        header.types.append(tok.at(2));  // tok.at(2) = type of curve (voltage, current, etc)
+                    }
+                    else {
+                        qDebug() << "List of variables too short.";
+                        header.variables.append(QString("var%1").arg(i));
+                        header.types.append(QString());
+                    }
                 }
             }
+            else if( keyword == "values" || keyword == "binary" ) {
+                // Record the position of the data, and skip it
+                header.binary = (keyword == "binary");
+                header.offset = file->pos();
 
-            // Avoid the first var, as it is the frequency base for the
-            // rest of the curves.
-            for(int i = 1; i < nvars; i++){
-                // Copy the data into the curves
-                plotCurves[i]->setSamples(dataSamples[0], dataSamples[i], npoints);
-                plotCurvesPhase[i]->setSamples(dataSamples[0], dataSamplesPhase[i], npoints);
-                // Add the curve to the scene
-                chartScene()->addItem(plotCurves[i]);
-                chartScene()->addItem(plotCurvesPhase[i]);
+                m_plots.append(header);
+                chartScene()->addPlot(QString("%1: %2").arg(m_plots.size()).arg(header.name));
+                header = RawPlot();
+
+                const int plot = m_plots.size() - 1;
+                updatePlotSize(plot);
+
+                // A plot still being written (or truncated, for example if
+                // the simulation was aborted) is the last one in the file.
+                if(!m_plots.at(plot).complete) {
+                    break;
+                }
+
+                m_indexPos = m_plots.at(plot).offset + m_plots.at(plot).size;
+                file->seek(m_indexPos);
             }
-        }
 
-        // Delete the temporal data arrays
-        qDeleteAll(dataSamples);
-        qDeleteAll(dataSamplesPhase);
+            // Read the next line
+            lineStart = file->pos();
+            line = file->readLine();
+        }
     }
 
     /*!
-     * \brief Read the data in Binary format implementation
+     * \brief Updates the number of points of \a plot available in the file,
+     * and the size of their data.
      *
-     * Read the data in Binary format implementation. Here we must use a
-     * QDataStream object to serially read raw data from the file. We cannot
-     * use a QTextStream object as it assumes text data and "translates it"
-     * to text using the default codec (utf-8, iso-8859-1, etc). The data to
-     * be read from the file is composed by float numbers of 64 bit precision,
-     * little endian format.
+     * Simulators may write a placeholder number of points in the header
+     * while the plot is being written, and update it once the plot is
+     * complete, so the number is read again from the mapped file on each
+     * call. Until then, the available points are derived from the file size
+     * (binary data) or from the points found in the file (ascii data).
      *
-     * \sa parseAsciiData(), parseFile()
+     * \sa parseFile(), updateFile()
      */
-    void FormatRawSimulation::parseBinaryData(QTextStream *file, const int nvars, const int npoints, const bool real)
+    void FormatRawSimulation::updatePlotSize(int plot)
     {
-        // Create the arrays to deal with the data
-        QList<double*> dataSamples;               // List of curve's magnitude data. Once filled, used to set data in plotCurves.
-        QList<double*> dataSamplesPhase;          // List of curve's phase data. Used for complex numbers. Once filled, used to set data in plotCurves.
+        RawPlot &header = m_plots[plot];
+        ChartSampleStorePtr store = chartScene()->sampleStore();
+        const char *data = reinterpret_cast<const char*>(store->mappedData());
+        const char *fileEnd = data + store->mappedSize();
+
+        // Read the number of points written in the header
+        int count = 0;
+        if(header.pointsPos >= 0) {
+            const char *lineEnd = data + header.offset;
+            const char *pos = static_cast<const char*>(
+                    memchr(data + header.pointsPos, ':', lineEnd - data - header.pointsPos));
+            if(pos) {
+                ++pos;
+                while(pos < lineEnd && *pos == ' ') {
+                    ++pos;
+                }
+                while(pos < lineEnd && *pos >= '0' && *pos <= '9') {
+                    count = count*10 + (*pos - '0');
+                    ++pos;
+                }
+            }
+        }
 
-        for(int i = 0; i < nvars; i++) {
-            if(real) {
-                // If dealing with real numbers, create an array only for the magnitude and use the provided curve types
-                double *data = new double[npoints];  // Create new dataset
-                dataSamples.append(data);  // Append new data set to the list
+        if(header.binary) {
+            // Avoid reading past the end of the file, in case it is still
+            // being written or it was truncated.
+            const qint64 stride = header.nvars * (header.real ? 1 : 2) * sizeof(double);
+            qint64 available = stride > 0 ? (store->mappedSize() - header.offset) / stride : 0;
+
+            header.complete = stride == 0 || (count > 0 && available >= count);
+            if(header.complete) {
+                available = qMin(available, qint64(count));
             }
-            else {
-                // If dealing with complex numbers, create an array for the magnitude and another one for the phase
-                double *data = new double[npoints];  // Create new dataset
-                double *dataPhase = new double[npoints];  // Create new dataset
-                dataSamples.append(data);  // Append new data set to the list
-                dataSamplesPhase.append(dataPhase);  // Append new data set to the list
+            else if(count > 0 && !m_following) {
+                qDebug() << "Warning: raw file too short, reading only" << available << "points.";
             }
+
+            header.npoints = int(available);
+            header.size = available * stride;
         }
+        else {
+            // The data ends at the header of the following plot, if any
+            const char *begin = data + header.offset;
+            const char *end = RawAsciiParser::dataEnd(begin + header.parsedSize, fileEnd);
+
+            // Find the index of the last point not yet read
+            const char *last = RawAsciiParser::lastPointStart(begin + header.parsedSize, end);
+            int lastIndex = header.loadedPoints - 1;
+            if(last < end) {
+                const char *pos = last;
+                while(pos < end && *pos == ' ') {
+                    ++pos;
+                }
+                lastIndex = 0;
+                while(pos < end && *pos >= '0' && *pos <= '9') {
+                    lastIndex = lastIndex*10 + (*pos - '0');
+                    ++pos;
+                }
+            }
 
-        // Construct a QDataStream object to serially read raw data.
-        // We cannot use QTextStream as it is locale aware, and will
-        // automatically decode the input using a codec.
-        QIODevice *device = file->device();
-        device->seek(file->pos());  // Seek the previous file position (where the QTextStream left off).
+            header.complete = end < fileEnd || (count > 0 && lastIndex + 1 >= count);
+            if(header.complete && count > 0) {
+                lastIndex = qMin(lastIndex, count - 1);
+            }
+            else if(last < end && m_following) {
+                // The last point may be only partially written while the
+                // plot is still being simulated, so it is left for the next
+                // update. A file opened once is read up to its end, as for
+                // example the last plot of an aborted simulation.
+                end = last;
+                lastIndex--;
+            }
 
-        QDataStream out(device);  // Construct a QDataStream object to serially read raw data
-        out.setByteOrder(QDataStream::LittleEndian);  // Use little endian format.
-        out.setFloatingPointPrecision(QDataStream::DoublePrecision);  // Use 64 bit precision (this shouldn't be neccessary as it is the default).
+            header.npoints = lastIndex + 1;
+            header.size = end - begin;
+        }
+    }
 
-        // Read the data
-        if(real) {
-            // The data is of type real
-            for(int i = 0; i < npoints; i++){
-                for(int j = 0; j < nvars; j++){
-                    out >> dataSamples[j][i];
+    /*!
+     * \brief Read the data in Ascii format implementation
+     *
+     * Read the data in Ascii format implementation. The raw file is memory
+     * mapped (see ChartSampleStore), and the data section is split into
+     * chunks, one for each available processor. Each chunk starts at the
+     * beginning of a data point, and is parsed by a RawAsciiParser on a
+     * different thread. The numbers are parsed in place, without creating
+     * intermediate strings, directly into the arrays later appended to the
+     * scene sample store.
+     *
+     * Only the points not read by a previous call are parsed, so that the
+     * plot can be read incrementally while the file is being written.
+     *
+     * \sa parseBinaryData(), parseFile(), RawAsciiParser
+     */
+    void FormatRawSimulation::parseAsciiData(int plot)
+    {
+        RawPlot &header = m_plots[plot];
+        const int nvars = header.nvars;
+        const int first = header.loadedPoints;
+        const int npoints = header.npoints - first;  // Points not yet read
+        const bool real = header.real;
+
+        ChartSampleStorePtr store = chartScene()->sampleStore();
+
+        // Create the columns of the scene sample store, shared by all
+        // curves, and point the curves to them.
+        if(header.columns.isEmpty()) {
+            header.columns.resize(nvars);
+            header.phaseColumns.resize(nvars);
+            for(int i = 0; i < nvars; i++) {
+                header.columns[i] = store->addColumn(QVector<double>());
+                if(!real && i > 0) {
+                    header.phaseColumns[i] = store->addColumn(QVector<double>());
                 }
             }
 
-            // Avoid the first var, as it is the time/frequency base
-            // for the rest of the curves.
+            // The first var is the time/frequency base for the rest of the curves.
             for(int i = 1; i < nvars; i++){
-                // Copy the data into the curves
-                plotCurves[i]->setSamples(dataSamples[0], dataSamples[i], npoints);
+                plotCurves[i]->setSampleColumns(store, header.columns[0], header.columns[i]);
                 // Add the curve to the scene
-                chartScene()->addItem(plotCurves[i]);
+                chartScene()->addItem(plotCurves[i], plot);
+
+                if(!real) {
+                    plotCurvesPhase[i]->setSampleColumns(store, header.columns[0], header.phaseColumns[i]);
+                    chartScene()->addItem(plotCurvesPhase[i], plot);
+                }
             }
         }
-        else {
-            // The data is of type complex
-            double real = 0;
-            double imaginary = 0;
-            double magnitude = 0;
-            double phase = 0;
 
-            // Read the data values, converting the complex data into
-            // magnitude and phase data.
-            for(int i = 0; i < npoints; i++){
-                for(int j = 0; j < nvars; j++){
-                    out >> real;  // Get the real part
-                    out >> imaginary;  // Get the imaginary part
+        if(npoints <= 0) {
+            return;
+        }
 
-                    magnitude = qSqrt(real*real + imaginary*imaginary);  // Calculate the magnitude part
-                    phase = qAtan(imaginary/real) * 180/M_PI;  // Calculate the phase part
+        const char *begin = reinterpret_cast<const char*>(store->mappedData()) +
+                header.offset + header.parsedSize;
+        const char *end = reinterpret_cast<const char*>(store->mappedData()) +
+                header.offset + header.size;
 
-                    dataSamples[j][i] = magnitude;
-                    dataSamplesPhase[j][i] = phase;
+        // Create the arrays to deal with the data. Once filled, they are
+        // appended to the scene sample store.
+        QVector<QVector<double> > dataSamples(nvars);       // List of curve's magnitude data.
+        QVector<QVector<double> > dataSamplesPhase(nvars);  // List of curve's phase data. Used for complex numbers.
+        QVector<double*> magnitude(nvars);
+        QVector<double*> phase(nvars);
+
+        for(int i = 0; i < nvars; i++) {
+            dataSamples[i].resize(npoints);
+            magnitude[i] = dataSamples[i].data();
+            if(!real) {
+                // If dealing with complex numbers, create an array for the phase too
+                dataSamplesPhase[i].resize(npoints);
+                phase[i] = dataSamplesPhase[i].data();
+            }
+        }
+
+        // Split the data into chunks, avoiding threads for small files.
+        const qint64 minChunkSize = 1 << 20;
+        int chunks = qMax(QThread::idealThreadCount(), 1);
+        chunks = int(qMin(qint64(chunks), qMax(qint64(end - begin) / minChunkSize, qint64(1))));
+
+        QList<RawAsciiParser*> parsers;
+        const char *chunkBegin = begin;
+        for(int i = 0; i < chunks; i++) {
+            const char *chunkEnd = (i == chunks - 1) ? end :
+                RawAsciiParser::nextPoint(begin + (end - begin) * (i + 1) / chunks, end);
+            chunkEnd = qMax(chunkEnd, chunkBegin);
+
+            parsers.append(new RawAsciiParser(chunkBegin, chunkEnd, end, nvars, first, npoints,
+                                              real, magnitude.data(), phase.data()));
+            chunkBegin = chunkEnd;
+        }
+
+        // Parse all chunks, using the current thread for the last one.
+        QThreadPool pool;
+        for(int i = 0; i < parsers.size() - 1; i++) {
+            pool.start(parsers.at(i));
+        }
+        parsers.last()->run();
+        pool.waitForDone();
+
+        // If the file was truncated (for example, if the simulation was
+        // aborted), use only the points actually read.
+        int points = first - 1;
+        foreach(RawAsciiParser *parser, parsers) {
+            points = qMax(points, parser->lastPoint());
+        }
+        points += 1 - first;
+        qDeleteAll(parsers);
+
+        if(points < npoints) {
+            qDebug() << "Warning: raw file too short, reading only" << first + points << "points.";
+            for(int i = 0; i < nvars; i++) {
+                dataSamples[i].resize(points);
+                if(!real) {
+                    dataSamplesPhase[i].resize(points);
                 }
             }
+        }
 
-            // Convert the magnitude values into dB ( dB = 20*log10(V) ).
-            // Avoid the first var (var=0), as it is the frequency base
-            // for the rest of the curves.
-            for(int i = 0; i < npoints; i++){
+        // Append the new points to the shared samples
+        for(int i = 0; i < nvars; i++){
+            store->appendToColumn(header.columns[i], dataSamples[i]);
+            if(!real && i > 0) {
+                store->appendToColumn(header.phaseColumns[i], dataSamplesPhase[i]);
+            }
+        }
+
+        header.loadedPoints = first + points;
+        header.parsedSize = header.size;
+    }
+
+    /*!
+     * \brief Read the data in Binary format implementation
+     *
+     * Read the data in Binary format implementation. Instead of serially
+     * reading the samples from the file, the raw file is memory mapped (see
+     * ChartSampleStore) and each curve reads its samples straight from the
+     * mapped region. This avoids both the per sample stream calls and the
+     * copy of the whole data set into new arrays, keeping the memory usage
+     * low even for very large files. The data in the file is composed by
+     * float numbers of 64 bit precision, little endian format, stored one
+     * point after the other (all variables of the first point, then all
+     * variables of the second point, etc).
+     *
+     * Complex numbers (ac simulations) must be converted into magnitude and
+     * phase before being plotted, so in that case only the frequency base is
+     * used from the mapped region, while the converted values are stored in
+     * new arrays.
+     *
+     * Only the points not read by a previous call are converted, so that the
+     * plot can be read incrementally while the file is being written.
+     *
+     * \sa parseAsciiData(), parseFile(), ChartSampleStore
+     */
+    void FormatRawSimulation::parseBinaryData(int plot)
+    {
+        RawPlot &header = m_plots[plot];
+        const int nvars = header.nvars;
+        const int first = header.loadedPoints;
+        const int points = header.npoints;  // Already limited to the file size
+        const bool real = header.real;
+        const qint64 offset = header.offset;
+
+        const int sampleSize = real ? sizeof(double) : 2*sizeof(double);
+        const int stride = nvars * sampleSize;
+
+        ChartSampleStorePtr store = chartScene()->sampleStore();
+
+        // Create the columns of the scene sample store, shared by all
+        // curves, and point the curves to them.
+        if(header.columns.isEmpty()) {
+            header.columns.resize(nvars);
+            header.phaseColumns.resize(nvars);
+
+            if(real) {
+                // The data is of type real. Every column is mapped, as
+                // values can be plotted without any conversion.
+                for(int j = 0; j < nvars; j++){
+                    header.columns[j] = store->addMappedColumn(offset + j*sampleSize, stride, 0);
+                }
+            }
+            else {
+                // The data is of type complex. The real part of the first
+                // variable is the frequency base, and can be used as is.
+                header.columns[0] = store->addMappedColumn(offset, stride, 0);
                 for(int j = 1; j < nvars; j++){
-                    dataSamples[j][i] = 20*log10(dataSamples[j][i]);
+                    header.columns[j] = store->addColumn(QVector<double>());
+                    header.phaseColumns[j] = store->addColumn(QVector<double>());
                 }
             }
 
             // Avoid the first var, as it is the time/frequency base
             // for the rest of the curves.
             for(int i = 1; i < nvars; i++){
-                // Copy the data into the curves
-                plotCurves[i]->setSamples(dataSamples[0], dataSamples[i], npoints);
-                plotCurvesPhase[i]->setSamples(dataSamples[0], dataSamplesPhase[i], npoints);
+                // Point the curves to the shared samples
+                plotCurves[i]->setSampleColumns(store, header.columns[0], header.columns[i]);
                 // Add the curve to the scene
-                chartScene()->addItem(plotCurves[i]);
-                chartScene()->addItem(plotCurvesPhase[i]);
+                chartScene()->addItem(plotCurves[i], plot);
+
+                if(!real) {
+                    plotCurvesPhase[i]->setSampleColumns(store, header.columns[0], header.phaseColumns[i]);
+                    chartScene()->addItem(plotCurvesPhase[i], plot);
+                }
+            }
+        }
+
+        if(points <= first) {
+            return;
+        }
+
+        // Read the data
+        if(real) {
+            // Mapped columns just grow to the new number of points
+            for(int j = 0; j < nvars; j++){
+                store->setColumnSize(header.columns[j], points);
+            }
+        }
+        else {
+            store->setColumnSize(header.columns[0], points);
+            const uchar *data = store->mappedData() + offset + qint64(first) * stride;
+
+            // Read the data values, converting the complex data into
+            // magnitude (in dB, dB = 20*log10(V)) and phase data.
+            // Avoid the first var (var=0), as it is the frequency base
+            // for the rest of the curves.
+            for(int j = 1; j < nvars; j++){
+                QVector<double> magnitude(points - first);
+                QVector<double> phase(points - first);
+
+                complexToPolar(data + j*sampleSize, stride, magnitude.data(), phase.data(), points - first);
+
+                store->appendToColumn(header.columns[j], magnitude);
+                store->appendToColumn(header.phaseColumns[j], phase);
             }
         }
 
-        // Delete the temporal data arrays
-        qDeleteAll(dataSamples);
-        qDeleteAll(dataSamplesPhase);
+        header.loadedPoints = points;
+        header.parsedSize = header.size;
     }
 
     ChartScene* FormatRawSimulation::chartScene() const
@@ -23,8 +23,16 @@
 
 #include "component.h"
 
+#include <QHash>
+#include <QRunnable>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
 // Forward declarations
 class QString;
+class QTextStream;
+class QTimer;
 
 namespace Caneda
 {
@@ -39,7 +47,8 @@ namespace Caneda
     class XmlReader;
     class XmlWriter;
 
-    typedef QList<QPair<Port *, QString> > PortsNetlist;
+    //! \brief Net name of each port of a schematic.
+    typedef QHash<Port*, QString> PortsNetlist;
 
     /*!
      * \brief This class handles all the access to the schematic documents file
@@ -159,6 +168,29 @@ namespace Caneda
         LayoutDocument *m_layoutDocument;
     };
 
+    /*!
+     * \brief Cached state of a netlist generated from a schematic.
+     *
+     * \sa FormatSpice::generateSchematicNetlists()
+     */
+    struct NetlistCacheEntry
+    {
+        QByteArray hash;         //! \brief Hash of the schematic file contents.
+        QStringList schematics;  //! \brief Schematics needed by the netlist (hierarchy).
+        int libraryGeneration;   //! \brief LibraryManager::generation() of the models used.
+        QString simulator;       //! \brief Simulation engine the netlist was generated for.
+    };
+
+    //! \brief Netlist text of a component, and the definitions it needs.
+    struct ComponentNetlist
+    {
+        QString text;             //! \brief Netlist line(s) of the component.
+        QStringList models;       //! \brief Device models used.
+        QStringList subcircuits;  //! \brief Subcircuits used.
+        QStringList directives;   //! \brief Spice directives.
+        QStringList schematics;   //! \brief Schematics needed (hierarchy).
+    };
+
     /*!
      * \brief This class handles all the access to the raw spice simulation
      * documents file format.
@@ -172,6 +204,18 @@ namespace Caneda
      * not be supported at the moment (raw waveform data is only generated and
      * saved by the simulator).
      *
+     * The netlists of the schematics used in a hierarchy (see the
+     * %generateNetlist escape sequence) are only generated again when the
+     * contents of the schematic, or of any of its own children, changed
+     * since the last time they were generated, or when the libraries (and
+     * so the component models) were loaded again.
+     *
+     * The netlist is kept up to date while the schematic is edited: the
+     * scene notifies which components were inserted, removed or modified,
+     * and when ports were connected or disconnected. Only the netlist lines
+     * of those components, or of the components whose nets changed, are
+     * generated again on the next save().
+     *
      * \sa \ref DocumentFormats
      */
     class FormatSpice : public QObject
@@ -183,15 +227,113 @@ namespace Caneda
 
         bool save();
 
+    private Q_SLOTS:
+        void componentChanged(Component *component);
+        void connectionsChanged();
+
     private:
         QString generateNetlist();
+        ComponentNetlist generateComponentNetlist(Component *component);
         PortsNetlist generateNetlistTopology();
-        void replacePortNames(PortsNetlist *netlist);
+        QHash<int, QString> netLabels(const QHash<Port*, int> &nets);
+
+        static void generateSchematicNetlists(const QStringList &schematics);
+        static bool isNetlistUpToDate(const QString &schematic,
+                                      const QHash<QString, QByteArray> &hashes,
+                                      QSet<QString> &visited);
+        static QString netlistFileName(const QString &schematic);
+        static QHash<QString, NetlistCacheEntry>& netlistCache();
 
         GraphicsScene* graphicsScene() const;
         QString fileName() const;
 
         SchematicDocument *m_schematicDocument;
+        QStringList m_schematics;  //! \brief Schematics needed by the last netlist generated.
+
+        PortsNetlist m_netlist;            //! \brief Net names of the last netlist generated.
+        QHash<Port*, int> m_netNumbers;    //! \brief Net numbers of the last netlist generated.
+        QHash<Component*, ComponentNetlist> m_components;  //! \brief Netlist of each component.
+        QSet<Component*> m_changedComponents;  //! \brief Components modified since last netlist.
+        bool m_connectionsChanged;         //! \brief True if the nets changed since last netlist.
+        QString m_filePath;                //! \brief File path used in the last netlist.
+        QString m_text;                    //! \brief Last netlist saved.
+    };
+
+    //! \brief Header of one plot of a raw spice simulation file.
+    struct RawPlot
+    {
+        RawPlot() : nvars(0), npoints(0), real(true), binary(false),
+                    pointsPos(-1), offset(0), size(0), complete(false),
+                    loaded(false), loadedPoints(0), parsedSize(0) {}
+
+        QString name;           //! \brief Plot name (type of analysis).
+        QStringList variables;  //! \brief Names of the variables.
+        QStringList types;      //! \brief Types of the variables (voltage, current, etc).
+
+        int nvars;       //! \brief Number of variables.
+        int npoints;     //! \brief Number of points available in the file.
+        bool real;       //! \brief True for real numbers (transient), false for complex (ac).
+        bool binary;     //! \brief True for binary data, false for ascii data.
+
+        qint64 pointsPos;  //! \brief Position of the number of points line in the file.
+        qint64 offset;     //! \brief Position of the data in the file.
+        qint64 size;       //! \brief Size in bytes of the data available in the file.
+        bool complete;     //! \brief False while the plot is still being written.
+
+        bool loaded;        //! \brief True once the curves were created.
+        int loadedPoints;   //! \brief Number of points already read.
+        qint64 parsedSize;  //! \brief Size in bytes of the data already read.
+
+        QVector<int> columns;       //! \brief Store columns of each variable (magnitude if complex).
+        QVector<int> phaseColumns;  //! \brief Store columns of the phase of each complex variable.
+    };
+
+    /*!
+     * \brief This class parses one chunk of the data section of an ascii raw
+     * spice simulation file.
+     *
+     * The data section of the file is split into several chunks, each one
+     * starting at the beginning of a data point, and each chunk is parsed by
+     * a different thread (see FormatRawSimulation::parseAsciiData()). The
+     * numbers are parsed in place from the mapped file, without creating
+     * any intermediate strings, and written directly into the preallocated
+     * output arrays, at the position given by the index of each point.
+     *
+     * \sa FormatRawSimulation
+     */
+    class RawAsciiParser : public QRunnable
+    {
+    public:
+        RawAsciiParser(const char *begin, const char *end, const char *dataEnd,
+                       int nvars, int firstPoint, int npoints, bool real,
+                       double **magnitude, double **phase);
+
+        void run();
+
+        //! \brief Returns the greatest point index found in the chunk (or -1).
+        int lastPoint() const { return m_lastPoint; }
+
+        static const char* nextPoint(const char *pos, const char *end);
+        static const char* dataEnd(const char *begin, const char *end);
+        static const char* lastPointStart(const char *begin, const char *end);
+        static bool parseDouble(const char *&pos, const char *end, double *value);
+
+    private:
+        void flushComplex(const double *block, int first, int count);
+
+        const char *m_begin;
+        const char *m_end;
+        const char *m_dataEnd;
+
+        int m_nvars;
+        int m_firstPoint;  //! \brief Point index of the first element of the output arrays.
+        int m_npoints;
+        bool m_real;
+
+        double **m_magnitude;  //! \brief Output arrays (real data, or complex magnitude).
+        double **m_phase;      //! \brief Output arrays of complex phase.
+
+        int m_lastPoint;
     };
 
     /*!
@@ -207,6 +349,11 @@ namespace Caneda
      * not be supported at the moment (raw waveform data is only generated and
      * saved by the simulator).
      *
+     * While a simulation is running, the raw file can be followed (see
+     * startFollowing()). The file is then polled for new data, and only the
+     * points written since the last poll are read and appended to the
+     * curves, so that the waveforms grow as the simulation advances.
+     *
      * \sa \ref DocumentFormats
      */
     class FormatRawSimulation : public QObject
@@ -217,16 +364,33 @@ namespace Caneda
         explicit FormatRawSimulation(SimulationDocument *document = 0);
 
         bool load();
+        bool loadPlot(int plot);
+
+        void startFollowing();
+        void stopFollowing();
+        //! \brief Returns true while the file is being followed.
+        bool isFollowing() const { return m_following; }
+
+    private Q_SLOTS:
+        void followFile();
 
     private:
+        void updateFile();
         void parseFile(QTextStream *file);
-        void parseAsciiData(QTextStream *file, const int nvars, const int npoints, const bool real);
-        void parseBinaryData(QTextStream *file, const int nvars, const int npoints, const bool real);
+        void updatePlotSize(int plot);
+        void parseAsciiData(int plot);
+        void parseBinaryData(int plot);
 
         ChartScene* chartScene() const;
 
         SimulationDocument *m_simulationDocument;
 
+        QList<RawPlot> m_plots;  // Index of the plots in the file.
+        qint64 m_indexPos;       // Position in the file after the last complete plot.
+
+        bool m_following;        // True while the file is still being written.
+        QTimer *m_followTimer;   // Polls the file for new data while following.
+
         QList<ChartSeries*> plotCurves;       // List of magnitude curves.
         QList<ChartSeries*> plotCurvesPhase;  // List of phase curves.
     };
@@ -121,6 +121,18 @@ namespace Caneda
     //! \brief Render hints
     static const QPainter::RenderHints DefaulRenderHints = QPainter::Antialiasing | QPainter::SmoothPixmapTransform;
 
+    /*!
+     * \brief Levels of detail below which items are simplified while painting.
+     *
+     * The level of detail is the one returned by
+     * QStyleOptionGraphicsItem::levelOfDetailFromTransform(), roughly the
+     * zoom level of the view.
+     */
+    static const qreal PortsLevelOfDetail = 0.5;    //!< \brief Ports are not drawn.
+    static const qreal TextLevelOfDetail = 0.4;     //!< \brief Property texts are not drawn.
+    static const qreal SymbolsLevelOfDetail = 0.2;  //!< \brief Symbols are drawn as boxes.
+    static const qreal WiresLevelOfDetail = 0.2;    //!< \brief Wires are drawn with hairlines.
+
 } // namespace Caneda
 
 #endif //GLOBAL_H
@@ -29,6 +29,7 @@
 #include "idocument.h"
 #include "iview.h"
 #include "library.h"
+#include "port.h"
 #include "portsymbol.h"
 #include "property.h"
 #include "propertydialog.h"
@@ -42,6 +43,7 @@
 #include <QMenu>
 #include <QPainter>
 #include <QShortcutEvent>
+#include <QStyleOptionGraphicsItem>
 #include <QtMath>
 
 namespace Caneda
@@ -70,6 +72,7 @@ namespace Caneda
         m_backgroundVisible = true;
 
         m_areItemsMoving = false;
+        m_specialMoveAnchor = 0;
         m_shortcutsBlocked = false;
 
         // Wire state machine
@@ -91,7 +94,25 @@ namespace Caneda
 
         m_zoomBandClicks = 0;
 
+        m_bulkLoading = false;
+
+        m_nextElectricalNet = 1;
+        m_electricalNetsDirty = false;
+        m_highlightedPort = 0;
+
         connect(undoStack(), SIGNAL(cleanChanged(bool)), this, SIGNAL(changed()));
+        connect(this, SIGNAL(selectionChanged()), this, SLOT(highlightSelectedNet()));
+    }
+
+    /*!
+     * \brief Destructor.
+     *
+     * The selection changes while QGraphicsScene deletes the items, so the
+     * net highlighting is detached before that happens.
+     */
+    GraphicsScene::~GraphicsScene()
+    {
+        disconnect(this, SIGNAL(selectionChanged()), this, SLOT(highlightSelectedNet()));
     }
 
     /**********************************************************************
@@ -197,6 +218,10 @@ namespace Caneda
             ++it;
         }
 
+        QVector<GraphicsItem*> movedItems;
+        QVector<QPointF> initialPos;
+        QVector<QPointF> finalPos;
+
         it = items.begin();
         while(it != items.end()) {
             if((*it)->type() == GraphicsItem::WireType) {
@@ -236,10 +261,14 @@ namespace Caneda
 
             // Move item
             QPointF itemPos = (*it)->pos();
-            m_undoStack->push(new MoveItemCmd(*it, itemPos, itemPos + delta));;
+            movedItems << *it;
+            initialPos << itemPos;
+            finalPos << itemPos + delta;
             ++it;
         }
 
+        pushMoveCommand(movedItems, initialPos, finalPos);
+
         // Reconnect items
         connectItems(items);
         splitAndCreateNodes(items);
@@ -302,6 +331,10 @@ namespace Caneda
         qreal dx = (x2 - x1) / (items.size() - 1);
         qreal x = x1;
 
+        QVector<GraphicsItem*> movedItems;
+        QVector<QPointF> initialPos;
+        QVector<QPointF> finalPos;
+
         foreach(GraphicsItem *item, items) {
             if(item->type() == GraphicsItem::WireType) {
                 continue;
@@ -313,9 +346,13 @@ namespace Caneda
             x += dx;
 
             // Move the item to the new position
-            m_undoStack->push(new MoveItemCmd(item, item->pos(), newPos));
+            movedItems << item;
+            initialPos << item->pos();
+            finalPos << newPos;
         }
 
+        pushMoveCommand(movedItems, initialPos, finalPos);
+
         connectItems(items);
         splitAndCreateNodes(items);
 
@@ -342,6 +379,10 @@ namespace Caneda
         qreal dy = (y2 - y1) / (items.size() - 1);
         qreal y = y1;
 
+        QVector<GraphicsItem*> movedItems;
+        QVector<QPointF> initialPos;
+        QVector<QPointF> finalPos;
+
         foreach(GraphicsItem *item, items) {
             if(item->type() == GraphicsItem::WireType) {
                 continue;
@@ -353,9 +394,13 @@ namespace Caneda
             y += dy;
 
             // Move the item to the new position
-            m_undoStack->push(new MoveItemCmd(item, item->pos(), newPos));
+            movedItems << item;
+            initialPos << item->pos();
+            finalPos << newPos;
         }
 
+        pushMoveCommand(movedItems, initialPos, finalPos);
+
         connectItems(items);
         splitAndCreateNodes(items);
 
@@ -652,12 +697,20 @@ namespace Caneda
      * flexibility and to avoid infinite recursions when calling this method
      * from inside a newly created or deleted item.
      *
+     * While a bulk load is in progress the item is only queued, and its
+     * ports are connected later by endBulkLoad().
+     *
      * \param item: items to connect
      *
-     * \sa splitAndCreateNodes()
+     * \sa splitAndCreateNodes(), beginBulkLoad()
      */
     void GraphicsScene::connectItems(GraphicsItem *item)
     {
+        if(m_bulkLoading) {
+            m_pendingConnections << item;
+            return;
+        }
+
         // Find existing intersecting ports and connect
         foreach(Port *port, item->ports()) {
             Port *other = port->findCoincidingPort();
@@ -706,88 +759,520 @@ namespace Caneda
      * In that case, a connection must be made, thus the need to split the
      * colliding wire.
      *
-     * \return Returns true if new node was created.
-     *
      * \sa connectItems()
      */
     void GraphicsScene::splitAndCreateNodes(GraphicsItem *item)
     {
-        // Check for collisions in each port, otherwise the items intersect
-        // but no node should be created.
-        foreach(Port *port, item->ports()) {
-
-            // List of wires to delete after collision and creation of new wires
-            QList<Wire*> markedForDeletion;
+        QList<GraphicsItem*> items;
+        items << item;
+        splitAndCreateNodes(items);
+    }
 
-            // Detect all colliding items
-            QList<QGraphicsItem*> collisions = port->collidingItems(Qt::IntersectsItemBoundingRect);
+    /*!
+     * \copydoc splitAndCreateNodes(GraphicsItem *item)
+     *
+     * All the ports of \a items are resolved in a single pass. Each port
+     * looks up the wires passing through its position in the wire segments
+     * index, and the ports strictly inside a wire are collected, sorted along
+     * the wire (hits at the wire ends are regular connections, handled by
+     * connectItems()). Finally, each hit wire is split at all its hit points
+     * at once, instead of being split and reconnected once per port.
+     *
+     * \sa wiresAt()
+     */
+    void GraphicsScene::splitAndCreateNodes(QList<GraphicsItem *> &items)
+    {
+        // Collect the ports hitting the interior of each wire
+        QHash<Wire*, QMap<qreal, Port*> > hits;
+        foreach(GraphicsItem *item, items) {
+            foreach(Port *port, item->ports()) {
+                const QPointF pos = port->scenePos();
+
+                foreach(Wire *wire, wiresAt(pos)) {
+                    // If already connected, the collision is the result of a
+                    // previous connection, otherwise there is a new node.
+                    if(port->parentItem() == wire ||
+                            port->isConnectedTo(wire->port1()) ||
+                            port->isConnectedTo(wire->port2())) {
+                        continue;
+                    }
 
-            // Filter colliding wires only
-            foreach(QGraphicsItem *collidingItem, collisions) {
-                Wire* collidingWire = canedaitem_cast<Wire*>(collidingItem);
-                if(collidingWire) {
+                    // Calculate the start and end points. As the ports are
+                    // mapped in the parent's coordinate system, we must use
+                    // the positions in the global (scene) coordinate system.
+                    const QPointF startPoint = wire->port1()->scenePos();
+                    const QPointF endPoint   = wire->port2()->scenePos();
+                    const bool vertical = qRound(startPoint.x()) == qRound(endPoint.x());
+
+                    const qreal start = vertical ? startPoint.y() : startPoint.x();
+                    const qreal end   = vertical ? endPoint.y()   : endPoint.x();
+                    const qreal hit   = vertical ? pos.y()        : pos.x();
+                    if(hit <= qMin(start, end) || hit >= qMax(start, end)) {
+                        continue;
+                    }
 
-                    // If already connected, the collision is the result of the connection,
-                    // otherwise there is a potential new node.
-                    bool alreadyConnected = false;
-                    foreach(Port *portIterator, item->ports()) {
-                        alreadyConnected |=
-                                portIterator->isConnectedTo(collidingWire->port1()) ||
-                                portIterator->isConnectedTo(collidingWire->port2());
+                    QMap<qreal, Port*> &wireHits = hits[wire];
+                    if(!wireHits.contains(hit)) {
+                        wireHits.insert(hit, port);
                     }
+                }
+            }
+        }
+
+        QHash<Wire*, QMap<qreal, Port*> >::const_iterator it;
+        for(it = hits.constBegin(); it != hits.constEnd(); ++it) {
+            Wire *wire = it.key();
+            const QPointF startPoint = wire->port1()->scenePos();
+            const QPointF endPoint   = wire->port2()->scenePos();
+            const bool ascending = startPoint.x() + startPoint.y() < endPoint.x() + endPoint.y();
 
-                    if(!alreadyConnected){
-                        // Calculate the start, middle and end points. As the ports are mapped in the parent's
-                        // coordinate system, we must calculate the positions (via the mapToScene method) in
-                        // the global (scene) coordinate system.
-                        QPointF startPoint  = collidingWire->port1()->scenePos();
-                        QPointF middlePoint = port->scenePos();
-                        QPointF endPoint    = collidingWire->port2()->scenePos();
-
-                        // Mark old wire for deletion. The deletion is performed in a second
-                        // stage to avoid referencing null pointers inside the foreach loop.
-                        markedForDeletion << collidingWire;
-
-                        // Create two new wires
-                        Wire *wire1 = new Wire(startPoint, middlePoint);
-                        Wire *wire2 = new Wire(middlePoint, endPoint);
-                        addItem(wire1);
-                        addItem(wire2);
-
-                        // Create new node (connections to the colliding wire)
-                        port->connectTo(wire1->port2());
-                        port->connectTo(wire2->port1());
-
-                        wire1->updateGeometry();
-                        wire2->updateGeometry();
-
-                        // Restore old wire connections
-                        connectItems(wire1);
-                        connectItems(wire2);
+            // Order the hit ports from the start to the end of the wire
+            QList<Port*> nodes;
+            QMap<qreal, Port*>::const_iterator hit;
+            for(hit = it.value().constBegin(); hit != it.value().constEnd(); ++hit) {
+                if(ascending) {
+                    nodes.append(hit.value());
+                }
+                else {
+                    nodes.prepend(hit.value());
+                }
+            }
+
+            // Replace the wire by a chain of new wires through all the nodes
+            QPointF segmentStart = startPoint;
+            Port *previousNode = 0;
+            Wire *firstWire = 0;
+            Wire *lastWire = 0;
+            foreach(Port *node, nodes) {
+                lastWire = new Wire(segmentStart, node->scenePos());
+                addItem(lastWire);
+                lastWire->updateGeometry();
+
+                if(previousNode) {
+                    previousNode->connectTo(lastWire->port1());
+                }
+                else {
+                    firstWire = lastWire;
+                }
+                node->connectTo(lastWire->port2());
+
+                segmentStart = node->scenePos();
+                previousNode = node;
+            }
+
+            lastWire = new Wire(segmentStart, endPoint);
+            addItem(lastWire);
+            lastWire->updateGeometry();
+            previousNode->connectTo(lastWire->port1());
+
+            // Restore old wire connections
+            connectItems(firstWire);
+            connectItems(lastWire);
+        }
+
+        // Delete the split wires. The deletion is performed in a second stage
+        // to avoid referencing deleted wires while splitting.
+        qDeleteAll(hits.keys());
+    }
+
+    /*!
+     * \brief Starts deferring item connections.
+     *
+     * This method is used when many items are added at once, for example
+     * while loading a schematic. Instead of searching coinciding ports each
+     * time an item is added, connectItems() only records the item, and all
+     * pending items are connected in a single pass by endBulkLoad().
+     *
+     * \sa endBulkLoad(), connectItems()
+     */
+    void GraphicsScene::beginBulkLoad()
+    {
+        m_bulkLoading = true;
+    }
+
+    /*!
+     * \brief Connects all items added since beginBulkLoad().
+     *
+     * Every port of the pending items is looked up once in the ports index,
+     * and connected to all coinciding ports of other items. As the index is
+     * hashed by position, the whole pass is linear in the number of ports.
+     *
+     * \sa beginBulkLoad(), portsAt()
+     */
+    void GraphicsScene::endBulkLoad()
+    {
+        m_bulkLoading = false;
+
+        foreach(GraphicsItem *item, m_pendingConnections) {
+            foreach(Port *port, item->ports()) {
+                foreach(Port *other, portsAt(port->scenePos())) {
+                    if(other->parentItem() != port->parentItem() &&
+                            !port->isConnectedTo(other)) {
+                        port->connectTo(other);
                     }
                 }
             }
+        }
+
+        m_pendingConnections.clear();
+    }
+
+    //! \brief Returns the key of the ports index for the scene position \a pos.
+    static quint64 portKey(const QPointF &pos)
+    {
+        return (quint64(quint32(qRound(pos.x()))) << 32) | quint32(qRound(pos.y()));
+    }
+
+    /*!
+     * \brief Adds \a port to the ports index, or updates its position if
+     * already added.
+     *
+     * \sa removePort(), portsAt()
+     */
+    void GraphicsScene::addPort(Port *port)
+    {
+        const quint64 key = portKey(port->scenePos());
+
+        QHash<Port*, quint64>::iterator it = m_portKeys.find(port);
+        if(it != m_portKeys.end()) {
+            if(it.value() == key) {
+                return;
+            }
+            m_portsIndex.remove(it.value(), port);
+            it.value() = key;
+        }
+        else {
+            m_portKeys.insert(port, key);
+
+            // A new port starts an electrical net of its own, joined to the
+            // ports it is already connected to, and to the other end if the
+            // port belongs to a wire.
+            if(!m_electricalNetsDirty) {
+                const int net = m_nextElectricalNet++;
+                m_electricalNets.insert(port, net);
+                m_electricalNetPorts[net] << port;
+            }
+
+            foreach(Port *other, port->connections()) {
+                if(other != port && m_portKeys.contains(other)) {
+                    joinElectricalNets(port, other);
+                }
+            }
+
+            if(port->parentItem() && port->parentItem()->type() == GraphicsItem::WireType) {
+                Wire *wire = static_cast<Wire*>(port->parentItem());
+                Port *end = (wire->port1() == port) ? wire->port2() : wire->port1();
+                if(m_portKeys.contains(end)) {
+                    joinElectricalNets(port, end);
+                }
+            }
+        }
 
-            // Delete all wires marked for deletion. The deletion is performed
-            // in a second stage to avoid referencing null pointers inside the
-            // foreach loop.
-            foreach(Wire *w, markedForDeletion) {
-                delete w;
+        m_portsIndex.insert(key, port);
+    }
+
+    /*!
+     * \brief Removes \a port from the ports index.
+     *
+     * A port without connections can not split its electrical net, as it
+     * is at most the end of a wire, so it is simply dropped from its net.
+     * Otherwise the nets are marked for a rebuild.
+     */
+    void GraphicsScene::removePort(Port *port)
+    {
+        QHash<Port*, quint64>::iterator it = m_portKeys.find(port);
+        if(it != m_portKeys.end()) {
+            m_portsIndex.remove(it.value(), port);
+            m_portKeys.erase(it);
+
+            // The rest of the highlighted net is drawn normally again
+            if(port == m_highlightedPort) {
+                m_highlightedPort = 0;
+                update();
+                updateWireLayer(sceneRect());
             }
 
-            // Clear the list to avoid dereferencing deleted wires
-            markedForDeletion.clear();
+            if(port->hasAnyConnection()) {
+                invalidateElectricalNets();
+            }
+            else if(!m_electricalNetsDirty) {
+                const int net = m_electricalNets.take(port);
+                QList<Port*> &ports = m_electricalNetPorts[net];
+                ports.removeOne(port);
+                if(ports.isEmpty()) {
+                    m_electricalNetPorts.remove(net);
+                }
+            }
         }
     }
 
-    //! \copydoc splitAndCreateNodes(GraphicsItem *item)
-    void GraphicsScene::splitAndCreateNodes(QList<GraphicsItem *> &items)
+    /*!
+     * \brief Returns the ports at the scene position \a pos.
+     *
+     * \sa addPort(), Port::findCoincidingPort()
+     */
+    QList<Port*> GraphicsScene::portsAt(const QPointF &pos) const
     {
-        foreach (GraphicsItem *item, items) {
-            splitAndCreateNodes(item);
+        QList<Port*> ports;
+
+        const quint64 key = portKey(pos);
+        QMultiHash<quint64, Port*>::const_iterator it = m_portsIndex.constFind(key);
+        while(it != m_portsIndex.constEnd() && it.key() == key) {
+            if(it.value()->scenePos() == pos) {
+                ports << it.value();
+            }
+            ++it;
+        }
+
+        return ports;
+    }
+
+    /*!
+     * \brief Returns the ports of the electrical net of \a port.
+     *
+     * The electrical net includes all the ports connected to \a port, either
+     * directly or through wires. Unlike Port::getEquipotentialPorts(), which
+     * walks the net on each call, the nets are kept by the scene and only
+     * rebuilt after a disconnection, so repeated queries are answered in
+     * constant time.
+     *
+     * \sa joinElectricalNets(), invalidateElectricalNets()
+     */
+    QList<Port*> GraphicsScene::electricalNet(Port *port)
+    {
+        updateElectricalNets();
+        return m_electricalNetPorts.value(m_electricalNets.value(port));
+    }
+
+    /*!
+     * \brief Joins the electrical nets of \a port1 and \a port2.
+     *
+     * This is called when two ports are connected. The smaller net is merged
+     * into the larger one, so that each port is moved at most a logarithmic
+     * number of times.
+     *
+     * \sa Port::connectTo(), electricalNet()
+     */
+    void GraphicsScene::joinElectricalNets(Port *port1, Port *port2)
+    {
+        if(m_electricalNetsDirty) {
+            return;
+        }
+
+        int net = m_electricalNets.value(port1);
+        int merged = m_electricalNets.value(port2);
+        if(net == merged || !net || !merged) {
+            return;
+        }
+
+        if(m_electricalNetPorts[net].size() < m_electricalNetPorts[merged].size()) {
+            qSwap(net, merged);
+        }
+
+        const QList<Port*> mergedPorts = m_electricalNetPorts.take(merged);
+        foreach(Port *port, mergedPorts) {
+            m_electricalNets.insert(port, net);
+        }
+        m_electricalNetPorts[net] << mergedPorts;
+
+        // Update the highlight if it grew
+        if(m_highlightedPort && m_electricalNets.value(m_highlightedPort) == net) {
+            updateNetItems(m_electricalNetPorts.value(net));
+        }
+    }
+
+    /*!
+     * \brief Marks the electrical nets for a rebuild.
+     *
+     * This is called when ports are disconnected, or removed from the scene
+     * while still connected, as a net can not be split incrementally. The nets are rebuilt once, on
+     * the next query.
+     *
+     * \sa Port::disconnect(), electricalNet()
+     */
+    void GraphicsScene::invalidateElectricalNets()
+    {
+        if(m_electricalNetsDirty) {
+            return;
+        }
+
+        m_electricalNetsDirty = true;
+        m_electricalNets.clear();
+        m_electricalNetPorts.clear();
+
+        // The highlighted net may have shrunk
+        if(m_highlightedPort) {
+            update();
+            updateWireLayer(sceneRect());
+        }
+    }
+
+    //! \brief Rebuilds the electrical nets if they were invalidated.
+    void GraphicsScene::updateElectricalNets()
+    {
+        if(!m_electricalNetsDirty) {
+            return;
+        }
+
+        m_electricalNets = Port::equipotentialNets(m_portKeys.keys());
+
+        QHash<Port*, int>::const_iterator it;
+        for(it = m_electricalNets.constBegin(); it != m_electricalNets.constEnd(); ++it) {
+            m_electricalNetPorts[it.value()] << it.key();
+        }
+
+        m_nextElectricalNet = m_electricalNetPorts.size() + 1;
+        m_electricalNetsDirty = false;
+    }
+
+    /*!
+     * \brief Highlights the electrical net of \a port, or removes the
+     * highlight if \a port is null.
+     *
+     * The highlight follows the edits of the net, as the items query
+     * isNetHighlighted() when painted.
+     *
+     * \sa isNetHighlighted(), electricalNet()
+     */
+    void GraphicsScene::setHighlightedNet(Port *port)
+    {
+        if(port == m_highlightedPort) {
+            return;
+        }
+
+        if(m_highlightedPort) {
+            updateNetItems(electricalNet(m_highlightedPort));
+        }
+
+        m_highlightedPort = port;
+
+        if(m_highlightedPort) {
+            updateNetItems(electricalNet(m_highlightedPort));
+        }
+    }
+
+    //! \brief Returns true if \a port belongs to the highlighted electrical net.
+    bool GraphicsScene::isNetHighlighted(Port *port)
+    {
+        if(!m_highlightedPort) {
+            return false;
+        }
+
+        updateElectricalNets();
+        const int net = m_electricalNets.value(m_highlightedPort);
+        return net && m_electricalNets.value(port) == net;
+    }
+
+    /*!
+     * \brief Highlights the electrical net of the selected wire, if any.
+     *
+     * The net of a component or port symbol is highlighted by clicking one
+     * of its ports (see normalEvent()).
+     */
+    void GraphicsScene::highlightSelectedNet()
+    {
+        Port *port = 0;
+
+        QList<QGraphicsItem*> selected = selectedItems();
+        if(selected.size() == 1) {
+            Wire *wire = canedaitem_cast<Wire*>(selected.first());
+            if(wire) {
+                port = wire->port1();
+            }
+        }
+
+        setHighlightedNet(port);
+    }
+
+    //! \brief Repaints the items owning \a ports.
+    void GraphicsScene::updateNetItems(const QList<Port*> &ports)
+    {
+        foreach(Port *port, ports) {
+            port->parentItem()->update();
+
+            // Highlighted wires move in or out of the wire layer
+            if(port->parentItem()->type() == GraphicsItem::WireType) {
+                updateWireLayer(port->parentItem()->sceneBoundingRect());
+            }
         }
     }
 
+    /*!
+     * \brief Adds \a wire to the wire segments index, or updates its position
+     * if already added.
+     *
+     * Vertical wires are bucketed by their x coordinate and horizontal wires
+     * by their y coordinate. Diagonal wires are removed from the index.
+     *
+     * \sa removeWire(), wiresAt()
+     */
+    void GraphicsScene::addWire(Wire *wire)
+    {
+        removeWire(wire);
+
+        const QPointF startPoint = wire->port1()->scenePos();
+        const QPointF endPoint   = wire->port2()->scenePos();
+
+        if(qRound(startPoint.x()) == qRound(endPoint.x())) {
+            const int key = qRound(startPoint.x());
+            m_verticalWires.insert(key, wire);
+            m_wireKeys.insert(wire, key);
+        }
+        else if(qRound(startPoint.y()) == qRound(endPoint.y())) {
+            const int key = qRound(startPoint.y());
+            m_horizontalWires.insert(key, wire);
+            m_wireKeys.insert(wire, key);
+        }
+    }
+
+    //! \brief Removes \a wire from the wire segments index.
+    void GraphicsScene::removeWire(Wire *wire)
+    {
+        QHash<Wire*, int>::iterator it = m_wireKeys.find(wire);
+        if(it != m_wireKeys.end()) {
+            // A wire is stored in only one of the buckets
+            m_verticalWires.remove(it.value(), wire);
+            m_horizontalWires.remove(it.value(), wire);
+            m_wireKeys.erase(it);
+        }
+    }
+
+    /*!
+     * \brief Returns the horizontal and vertical wires passing through the
+     * scene position \a pos, including the wires ending at \a pos.
+     *
+     * \sa addWire(), splitAndCreateNodes()
+     */
+    QList<Wire*> GraphicsScene::wiresAt(const QPointF &pos) const
+    {
+        QList<Wire*> wires;
+
+        const int x = qRound(pos.x());
+        const int y = qRound(pos.y());
+
+        QMultiHash<int, Wire*>::const_iterator it = m_verticalWires.constFind(x);
+        while(it != m_verticalWires.constEnd() && it.key() == x) {
+            const qreal y1 = it.value()->port1()->scenePos().y();
+            const qreal y2 = it.value()->port2()->scenePos().y();
+            if(y >= qRound(qMin(y1, y2)) && y <= qRound(qMax(y1, y2))) {
+                wires << it.value();
+            }
+            ++it;
+        }
+
+        it = m_horizontalWires.constFind(y);
+        while(it != m_horizontalWires.constEnd() && it.key() == y) {
+            const qreal x1 = it.value()->port1()->scenePos().x();
+            const qreal x2 = it.value()->port2()->scenePos().x();
+            if(x >= qRound(qMin(x1, x2)) && x <= qRound(qMax(x1, x2))) {
+                wires << it.value();
+            }
+            ++it;
+        }
+
+        return wires;
+    }
+
     /**********************************************************************
      *
      *               Spice/electric related scene properties
@@ -808,6 +1293,9 @@ namespace Caneda
         m_properties->addProperty(property.name(), property);
     }
 
+    //! \brief Minimum distance in pixels between the grid points drawn.
+    static const int minimumGridPixels = 4;
+
     /*!
      * \brief Draw background of scene including grid
      *
@@ -822,18 +1310,16 @@ namespace Caneda
         // Disable anti aliasing
         painter->setRenderHint(QPainter::Antialiasing, false);
 
+        const RenderSettings &settings = Settings::instance()->renderSettings();
+
         if(isBackgroundVisible()) {
-            const QColor backgroundColor =
-                Settings::instance()->currentValue("gui/backgroundColor").value<QColor>();
             painter->setPen(Qt::NoPen);
-            painter->setBrush(QBrush(backgroundColor));
+            painter->setBrush(settings.backgroundBrush);
             painter->drawRect(rect);
         }
 
         // Configure pen
-        const QColor foregroundColor =
-            Settings::instance()->currentValue("gui/foregroundColor").value<QColor>();
-        painter->setPen(QPen(foregroundColor, 0));
+        painter->setPen(settings.gridPen);
         painter->setBrush(Qt::NoBrush);
 
         // Draw origin (if visible in the view)
@@ -843,27 +1329,32 @@ namespace Caneda
         }
 
         // Draw grid
-        if(Settings::instance()->currentValue("gui/gridVisible").value<bool>()) {
+        if(settings.gridVisible) {
 
             int drawingGridWidth = Caneda::DefaultGridSpace;
             int drawingGridHeight = Caneda::DefaultGridSpace;
 
-            //Make grid size display dinamic, depending on zoom level
-            DocumentViewManager *manager = DocumentViewManager::instance();
-            IView *v = manager->currentView();
-            GraphicsView *sv = qobject_cast<GraphicsView*>(v->toWidget());
-
-            if(sv) {
-                if(sv->currentZoom() < 1) {
-                    // While drawing, choose spacing to be multiple times the actual grid size.
-                    if(sv->currentZoom() > 0.5) {
-                        drawingGridWidth *= 4;
-                        drawingGridHeight *= 4;
-                    }
-                    else {
-                        drawingGridWidth *= 16;
-                        drawingGridHeight *= 16;
-                    }
+            // Make grid size display dinamic, depending on zoom level. The
+            // zoom level is taken from the painter, as the scene may be drawn
+            // in views other than the current one, and does not depend on
+            // the view being rotated or mirrored.
+            const qreal zoom = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+            if(zoom > 0 && zoom < 1) {
+                // While drawing, choose spacing to be multiple times the actual grid size.
+                if(zoom > 0.5) {
+                    drawingGridWidth *= 4;
+                    drawingGridHeight *= 4;
+                }
+                else {
+                    drawingGridWidth *= 16;
+                    drawingGridHeight *= 16;
+                }
+
+                // Keep the points apart on screen, so that the number of
+                // points depends on the view size and not on the scene area.
+                while(drawingGridWidth * zoom < minimumGridPixels) {
+                    drawingGridWidth *= 4;
+                    drawingGridHeight *= 4;
                 }
             }
 
@@ -874,18 +1365,111 @@ namespace Caneda
             qreal bottom = int(rect.bottom()) - (int(rect.bottom()) % drawingGridHeight);
             qreal x, y;
 
-            // Draw grid
-            painter->setBrush(Qt::NoBrush);
+            // Draw grid, with all the points in a single call
+            QVector<QPointF> points;
+            points.reserve((int((right - left) / drawingGridWidth) + 1) *
+                           (int((bottom - top) / drawingGridHeight) + 1));
             for(x = left; x <= right; x += drawingGridWidth) {
                 for(y = top; y <=bottom; y += drawingGridHeight) {
-                    painter->drawPoint(QPointF(x, y));
+                    points << QPointF(x, y);
                 }
             }
+
+            painter->drawPoints(points.constData(), points.size());
         }
 
         // Restore painter
         painter->setRenderHint(QPainter::Antialiasing, true);
         painter->setPen(savedpen);
+
+        // Draw the unselected wires below all the items
+        drawWireLayer(painter, rect);
+    }
+
+    /*!
+     * \brief Draw the wire layer of the scene.
+     *
+     * When the wire layer is enabled (see RenderSettings::wireLayer), the
+     * unselected wires are not painted one by one. Instead, all of them
+     * inside the exposed area are collected here and drawn with a single
+     * drawLines() call, avoiding a painter state change per wire. Selected
+     * wires and wires of the highlighted net are still painted by the wires
+     * themselves.
+     *
+     * The layer is drawn as the last step of drawBackground(), so the wires
+     * keep their place below all the other items. The views cache their
+     * background, so each wire invalidates the areas it changes (see
+     * updateWireLayer()).
+     *
+     * \param painter: Where to draw
+     * \param rect: Exposed area
+     *
+     * \sa isInWireLayer(), Wire::paint()
+     */
+    void GraphicsScene::drawWireLayer(QPainter *painter, const QRectF &rect)
+    {
+        const RenderSettings &settings = Settings::instance()->renderSettings();
+        if(!settings.wireLayer) {
+            return;
+        }
+
+        QVector<QLineF> lines;
+        foreach(QGraphicsItem *item, items(rect, Qt::IntersectsItemBoundingRect)) {
+            Wire *wire = canedaitem_cast<Wire*>(item);
+            if(wire && wire->isVisible() && isInWireLayer(wire)) {
+                lines << QLineF(wire->port1()->scenePos(), wire->port2()->scenePos());
+            }
+        }
+
+        if(lines.isEmpty()) {
+            return;
+        }
+
+        QPen savedPen = painter->pen();
+
+        // When zoomed out, hairlines are drawn faster and look the same
+        QPen pen = settings.linePen;
+        if(QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform()) <
+                Caneda::WiresLevelOfDetail) {
+            pen.setWidth(0);
+        }
+        painter->setPen(pen);
+
+        painter->drawLines(lines);
+
+        painter->setPen(savedPen);
+    }
+
+    /*!
+     * \brief Returns true if \a wire is painted by the wire layer of the
+     * scene instead of by itself.
+     *
+     * \sa drawWireLayer()
+     */
+    bool GraphicsScene::isInWireLayer(Wire *wire)
+    {
+        return Settings::instance()->renderSettings().wireLayer &&
+                !wire->isSelected() && !isNetHighlighted(wire->port1());
+    }
+
+    /*!
+     * \brief Invalidates the cached background of the views in \a rect, if
+     * the wire layer is enabled.
+     *
+     * The area is grown by the wire pen width, as the wires may be drawn
+     * wider than their bounding rectangles.
+     *
+     * \sa drawWireLayer(), Wire::updateLayer()
+     */
+    void GraphicsScene::updateWireLayer(const QRectF &rect)
+    {
+        const RenderSettings &settings = Settings::instance()->renderSettings();
+        if(!settings.wireLayer || rect.isNull()) {
+            return;
+        }
+
+        const qreal margin = settings.linePen.widthF();
+        invalidate(rect.adjusted(-margin, -margin, margin, margin), BackgroundLayer);
     }
 
     /**********************************************************************
@@ -1143,6 +1727,14 @@ namespace Caneda
                 {
                     QGraphicsScene::mousePressEvent(event);
                     processForSpecialMove();
+
+                    // Clicking a port highlights its net, as selecting a wire does
+                    if(event->button() == Qt::LeftButton) {
+                        QList<Port*> ports = portsAt(event->scenePos());
+                        if(!ports.isEmpty()) {
+                            setHighlightedNet(ports.first());
+                        }
+                    }
                 }
                 break;
 
@@ -1154,7 +1746,6 @@ namespace Caneda
                             m_areItemsMoving = true;
                             m_undoStack->beginMacro(tr("Move items"));
 
-                            disconnectDisconnectibles();
                             QGraphicsScene::mouseMoveEvent(event);
                             specialMove();
                         }
@@ -1753,6 +2344,25 @@ namespace Caneda
         return max;
     }
 
+    /*!
+     * \brief Pushes an undo command moving each item of \a items from the
+     * position in \a initialPos to the one in \a finalPos, at the same index.
+     *
+     * A single item is moved with a MoveItemCmd, and several items with one
+     * MoveItemsCmd. Nothing is pushed if \a items is empty.
+     */
+    void GraphicsScene::pushMoveCommand(const QVector<GraphicsItem*> &items,
+                                        const QVector<QPointF> &initialPos,
+                                        const QVector<QPointF> &finalPos)
+    {
+        if(items.size() == 1) {
+            m_undoStack->push(new MoveItemCmd(items.first(), initialPos.first(), finalPos.first()));
+        }
+        else if(!items.isEmpty()) {
+            m_undoStack->push(new MoveItemsCmd(items, initialPos, finalPos));
+        }
+    }
+
     /******************************************************************
      *
      *                   Moving Events
@@ -1783,7 +2393,10 @@ namespace Caneda
     void GraphicsScene::processForSpecialMove()
     {
         disconnectibles.clear();
-        specialMoveItems.clear();
+        m_specialMoveEndpoints.clear();
+        m_specialMoveAnchor = 0;
+
+        QSet<Port*> endpoints;
 
         foreach(QGraphicsItem *qItem, selectedItems()) {
             GraphicsItem *item = canedaitem_cast<GraphicsItem*>(qItem);
@@ -1792,27 +2405,50 @@ namespace Caneda
                 // Save item's position for later use in undo/redo.
                 item->storePos();
 
+                if(!m_specialMoveAnchor) {
+                    m_specialMoveAnchor = item;
+                    m_specialMoveAnchorPos = item->scenePos();
+                }
+
                 // Check for disconnections and wire resizing
                 foreach(Port *port, item->ports()) {
 
-                    foreach(Port *other, *(port->connections())) {
-                        // If the item connected is a component, determine whether it should
-                        // be disconnected or not.
+                    // If the item connected is a component, determine whether it should
+                    // be disconnected or not. A port to be disconnected leaves its
+                    // wires and port symbols behind, with the unselected component.
+                    bool disconnectible = false;
+                    foreach(Port *other, port->connections()) {
                         if(other->parentItem()->type() == GraphicsItem::ComponentType &&
                                 !other->parentItem()->isSelected()) {
-                            disconnectibles << item;
+                            disconnectible = true;
+                            break;
                         }
-                        // If the item connected is a wire, determine whether it should be
-                        // resized or moved.
-                        if(other->parentItem()->type() == GraphicsItem::WireType &&
-                                !other->parentItem()->isSelected()) {
-                            specialMoveItems << other->parentItem();
+                    }
+
+                    if(disconnectible) {
+                        disconnectibles << item;
+                        continue;
+                    }
+
+                    foreach(Port *other, port->connections()) {
+                        GraphicsItem *otherItem = other->parentItem();
+                        if(otherItem->isSelected()) {
+                            continue;
                         }
-                        // If the item connected is a port, determine whether it should be
-                        // moved or not.
-                        if(other->parentItem()->type() == GraphicsItem::PortSymbolType &&
-                                !other->parentItem()->isSelected()) {
-                            specialMoveItems << other->parentItem();
+
+                        // If the item connected is a wire, its connected end must follow
+                        // the moving item. If the item connected is a port, it must be
+                        // moved along.
+                        if((otherItem->type() == GraphicsItem::WireType ||
+                            otherItem->type() == GraphicsItem::PortSymbolType) &&
+                                !endpoints.contains(other)) {
+                            endpoints << other;
+
+                            SpecialMoveEndpoint endpoint;
+                            endpoint.port = other;
+                            endpoint.startPos = (otherItem->type() == GraphicsItem::WireType) ?
+                                        other->scenePos() : otherItem->pos();
+                            m_specialMoveEndpoints << endpoint;
                         }
                     }
 
@@ -1837,59 +2473,40 @@ namespace Caneda
      * a gap would appear between the moved wire and the connected wires (which
      * would remain in their original place).
      *
+     * The affected endpoints are collected once by processForSpecialMove(),
+     * so each mouse move only translates them by the distance the selection
+     * moved, without walking the connections again.
+     *
      * \sa normalEvent(), processForSpecialMove()
      */
     void GraphicsScene::specialMove()
     {
-        foreach(GraphicsItem *item, specialMoveItems) {
+        if(!m_specialMoveAnchor) {
+            return;
+        }
 
-            // The wires in specialMoveItems are those wires that are not selected
-            // but whose geometry must acommodate to the current moving wire.
-            if(item->type() == GraphicsItem::WireType) {
+        const QPointF delta = m_specialMoveAnchor->scenePos() - m_specialMoveAnchorPos;
 
-                // Check both ports (port1 and port2) of the unselected wire for
-                // possible ports movement.
-                Wire *wire = canedaitem_cast<Wire*>(item);
+        foreach(const SpecialMoveEndpoint &endpoint, m_specialMoveEndpoints) {
+            const QPointF pos = endpoint.startPos + delta;
+            GraphicsItem *item = endpoint.port->parentItem();
 
-                // First check port1
-                foreach(Port *other, *(wire->port1()->connections())) {
-                    // If some of the connected ports has moved, we have found the
-                    // moving wire and this port must copy that port position.
-                    if(other->scenePos() != wire->port1()->scenePos()) {
-                        wire->movePort1(other->scenePos());
-                        break;
-                    }
+            // The wires are those wires that are not selected but whose
+            // geometry must acommodate to the current moving items.
+            if(item->type() == GraphicsItem::WireType) {
+                Wire *wire = static_cast<Wire*>(item);
+                if(wire->port1() == endpoint.port) {
+                    wire->movePort1(pos);
                 }
-
-                // Then check port2
-                foreach(Port *other, *(wire->port2()->connections())) {
-                    // If some of the connected ports has moved, we have found the
-                    // moving wire and this port must copy that port position.
-                    if(other->scenePos() != wire->port2()->scenePos()) {
-                        wire->movePort2(other->scenePos());
-                        break;
-                    }
+                else {
+                    wire->movePort2(pos);
                 }
-
             }
-
-            // The ports in specialMoveItems must be moved along the selected
-            // (and moving) wires.
-            if(item->type() == GraphicsItem::PortSymbolType) {
-
-                PortSymbol *portSymbol = canedaitem_cast<PortSymbol*>(item);
-
-                foreach(Port *other, *(portSymbol->port()->connections())) {
-                    // If some of the connected ports has moved, we have found the
-                    // moving item and this port must copy that port position.
-                    if(other->scenePos() != portSymbol->scenePos()) {
-                        portSymbol->setPos(other->scenePos());
-                        break;
-                    }
-                }
-
+            // The port symbols must be moved along the selected (and moving)
+            // items.
+            else {
+                item->setPos(pos);
             }
-
         }
     }
 
@@ -1897,26 +2514,38 @@ namespace Caneda
      * \brief End the special move and finalize wire's segements.
      *
      * This method ends the special move by pushing the necessary UndoCommands
-     * relative to position changes of items on a scene. Also finalize wire's
-     * segments.
+     * relative to position changes of items on a scene. The moved items are
+     * disconnected from the unselected components they were dragged away
+     * from, and reconnected at their final position, all at once.
      *
      * \sa normalEvent()
      */
     void GraphicsScene::endSpecialMove()
     {
+        disconnectDisconnectibles();
+
+        QList<GraphicsItem*> items;
+        QVector<GraphicsItem*> movedItems;
+        QVector<QPointF> initialPos;
+        QVector<QPointF> finalPos;
         foreach(QGraphicsItem *qItem, selectedItems()) {
             GraphicsItem *item = canedaitem_cast<GraphicsItem*>(qItem);
 
             if(item) {
-                m_undoStack->push(new MoveItemCmd(item, item->storedPos(),
-                            smartNearingGridPoint(item->pos())));
-
-                connectItems(item);
-                splitAndCreateNodes(item);
+                items << item;
+                movedItems << item;
+                initialPos << item->storedPos();
+                finalPos << smartNearingGridPoint(item->pos());
             }
         }
 
-        specialMoveItems.clear();
+        pushMoveCommand(movedItems, initialPos, finalPos);
+
+        connectItems(items);
+        splitAndCreateNodes(items);
+
+        m_specialMoveEndpoints.clear();
+        m_specialMoveAnchor = 0;
         disconnectibles.clear();
     }
 
@@ -1939,7 +2568,7 @@ namespace Caneda
             int disconnections = 0;
             foreach(Port *port, item->ports()) {
 
-                foreach(Port *other, *(port->connections())) {
+                foreach(Port *other, port->connections()) {
                     if(other->parentItem()->type() == GraphicsItem::ComponentType &&
                             other->parentItem() != item &&
                             !other->parentItem()->isSelected()) {
@@ -26,7 +26,9 @@
 
 #include <QGraphicsItem>
 #include <QGraphicsScene>
+#include <QHash>
 #include <QList>
+#include <QVector>
 
 #include <QtPrintSupport/QPrinter>
 
@@ -39,6 +41,7 @@ namespace Caneda
     class Component;
     class GraphicsItem;
     class Painting;
+    class Port;
     class Wire;
 
     /*!
@@ -68,6 +71,7 @@ namespace Caneda
 
     public:
         explicit GraphicsScene(QObject *parent = 0);
+        ~GraphicsScene();
 
         // Edit actions
         void cutItems(QList<GraphicsItem*> &items);
@@ -110,6 +114,30 @@ namespace Caneda
         void splitAndCreateNodes(GraphicsItem *item);
         void splitAndCreateNodes(QList<GraphicsItem *> &items);
 
+        void beginBulkLoad();
+        void endBulkLoad();
+
+        // Ports spatial index
+        void addPort(Port *port);
+        void removePort(Port *port);
+        QList<Port*> portsAt(const QPointF &pos) const;
+
+        // Wire segments index
+        void addWire(Wire *wire);
+        void removeWire(Wire *wire);
+        QList<Wire*> wiresAt(const QPointF &pos) const;
+
+        // Electrical nets
+        QList<Port*> electricalNet(Port *port);
+        void joinElectricalNets(Port *port1, Port *port2);
+        void invalidateElectricalNets();
+
+        void setHighlightedNet(Port *port);
+        bool isNetHighlighted(Port *port);
+
+        bool isInWireLayer(Wire *wire);
+        void updateWireLayer(const QRectF &rect);
+
         //! \brief Return current undo stack
         QUndoStack* undoStack() { return m_undoStack; }
 
@@ -117,9 +145,19 @@ namespace Caneda
         PropertyGroup* properties() { return m_properties; }
         void addProperty(Property property);
 
+        // Netlist related notifications
+        //! \brief Notifies that \a component was inserted, removed or its properties changed.
+        void notifyComponentChanged(Component *component) { emit componentChanged(component); }
+        //! \brief Notifies that some ports were connected or disconnected.
+        void notifyConnectionsChanged() { emit connectionsChanged(); }
+
     Q_SIGNALS:
         //! \brief This signal is emitted whenever the undostack enters or leaves the clean state.
         void changed();
+        //! \brief This signal is emitted when a component is inserted, removed or its properties change.
+        void componentChanged(Component *component);
+        //! \brief This signal is emitted when ports are connected or disconnected, or net names change.
+        void connectionsChanged();
         void mouseActionChanged(Caneda::MouseAction);
 
     protected:
@@ -136,7 +174,15 @@ namespace Caneda
         void wheelEvent(QGraphicsSceneWheelEvent *event);
         void contextMenuEvent(QGraphicsSceneContextMenuEvent *event);
 
+    private Q_SLOTS:
+        void highlightSelectedNet();
+
     private:
+        void drawWireLayer(QPainter *painter, const QRectF &rect);
+
+        void updateElectricalNets();
+        void updateNetItems(const QList<Port*> &ports);
+
         // Custom event handlers
         void sendMouseActionEvent(QGraphicsSceneMouseEvent *event);
         void normalEvent(QGraphicsSceneMouseEvent *event);
@@ -165,6 +211,9 @@ namespace Caneda
         // Custom private methods
         void placeItem(GraphicsItem *item, const QPointF &pos);
         int componentLabelSuffix(const QString& labelPrefix) const;
+        void pushMoveCommand(const QVector<GraphicsItem*> &items,
+                             const QVector<QPointF> &initialPos,
+                             const QVector<QPointF> &finalPos);
 
         void processForSpecialMove();
         void specialMove();
@@ -210,18 +259,30 @@ namespace Caneda
          * When a wire is moved and one of the connected components is
          * unselected, the component must be disconnected from the moving
          * wires' ports. The list of components to disconnect is selected in
-         * processForSpecialMove() and the disconnection is performed in the
-         * disconnect() method.
+         * processForSpecialMove() and the disconnection is performed in
+         * disconnectDisconnectibles(), once the move ends.
          */
         QList<GraphicsItem*> disconnectibles;
 
         /*!
-         * \brief List of items requiring special movements due to mouse event
+         * \brief Endpoint of an unselected item following a moving selection
+         *
+         * \sa m_specialMoveEndpoints
+         */
+        struct SpecialMoveEndpoint
+        {
+            Port *port;        //!< \brief Port of the wire or port symbol to move.
+            QPointF startPos;  //!< \brief Scene position when the move started.
+        };
+
+        /*!
+         * \brief Endpoints requiring special movements due to mouse event
          *
          * When an item is moved (click + drag) and one of the connected wires
          * is't selected, the latter's geometry needs to be altered to retain
-         * its connection. Hence the last wires must be selected in
-         * processForSpecialMove() and resized in specialMove().
+         * its connection. Hence the ends of those wires are collected once in
+         * processForSpecialMove(), and translated in specialMove() by the
+         * distance the selection moved.
          *
          * In a similar manner, some while some items must be disconnected (for
          * example normal components) others must be moved along with the wire
@@ -229,7 +290,11 @@ namespace Caneda
          *
          * \sa processForSpecialMove(), specialMove()
          */
-        QList<GraphicsItem*> specialMoveItems;
+        QVector<SpecialMoveEndpoint> m_specialMoveEndpoints;
+        //! \brief Selected item used to measure the distance moved
+        GraphicsItem *m_specialMoveAnchor;
+        //! \brief Scene position of m_specialMoveAnchor when the move started
+        QPointF m_specialMoveAnchorPos;
 
         /*!
          * \brief State variable for the current wire state.
@@ -270,6 +335,62 @@ namespace Caneda
 
         //! \brief Spice/electric related scene properties
         PropertyGroup *m_properties;
+
+        /*!
+         * \brief Ports in the scene, indexed by their grid snapped position
+         *
+         * This allows finding the ports coinciding at a given position with
+         * a single lookup, instead of checking the ports of all colliding
+         * items. The ports keep the index up to date when they are inserted,
+         * removed or moved (see Port::itemChange()).
+         *
+         * \sa addPort(), removePort(), portsAt()
+         */
+        QMultiHash<quint64, Port*> m_portsIndex;
+        //! \brief Key under which each port is stored in m_portsIndex
+        QHash<Port*, quint64> m_portKeys;
+
+        /*!
+         * \brief Vertical wires in the scene, indexed by their x coordinate
+         *
+         * Together with m_horizontalWires, this allows finding the wires
+         * passing through a given position with a single lookup. Diagonal
+         * wires are not indexed. The wires keep the index up to date when
+         * they are inserted, removed, moved or reshaped (see
+         * Wire::updateGeometry() and Wire::itemChange()).
+         *
+         * \sa addWire(), removeWire(), wiresAt()
+         */
+        QMultiHash<int, Wire*> m_verticalWires;
+        //! \brief Horizontal wires in the scene, indexed by their y coordinate
+        QMultiHash<int, Wire*> m_horizontalWires;
+        //! \brief Key under which each wire is stored in the wires index
+        QHash<Wire*, int> m_wireKeys;
+
+        /*!
+         * \brief Electrical net number of each port in the scene
+         *
+         * Ports connected together, or at both ends of a wire, share the same
+         * electrical net. Connections join the nets incrementally, merging the
+         * smaller net into the larger one, while disconnections and removed
+         * connected ports mark the nets for a rebuild on the next query.
+         *
+         * \sa electricalNet(), joinElectricalNets(), invalidateElectricalNets()
+         */
+        QHash<Port*, int> m_electricalNets;
+        //! \brief Ports of each electrical net
+        QHash<int, QList<Port*> > m_electricalNetPorts;
+        //! \brief Number assigned to the next new electrical net
+        int m_nextElectricalNet;
+        //! \brief True if the electrical nets must be rebuilt
+        bool m_electricalNetsDirty;
+        //! \brief Port whose electrical net is highlighted, if any
+        Port *m_highlightedPort;
+
+        //! \brief True while connections are deferred by beginBulkLoad()
+        bool m_bulkLoading;
+        //! \brief Items whose connection is pending until endBulkLoad()
+        QList<GraphicsItem*> m_pendingConnections;
     };
 
 } // namespace Caneda
@@ -47,6 +47,7 @@
 #include <QTextCodec>
 #include <QTextDocument>
 #include <QTextStream>
+#include <QTimer>
 
 namespace Caneda
 {
@@ -624,6 +625,9 @@ namespace Caneda
     SchematicDocument::SchematicDocument(QObject *parent) : IDocument(parent)
     {
         m_graphicsScene = new GraphicsScene(this);
+        m_spiceFormat = 0;
+        m_liveWaveformsTimer = new QTimer(this);
+        connect(m_liveWaveformsTimer, SIGNAL(timeout()), this, SLOT(openLiveWaveforms()));
         connect(m_graphicsScene, SIGNAL(changed()), this,
                 SLOT(emitDocumentChanged()));
         connect(m_graphicsScene->undoStack(), SIGNAL(canUndoChanged(bool)),
@@ -802,14 +806,38 @@ namespace Caneda
         QString baseName = info.completeBaseName();
         QString path = info.path();
 
-        // First export the schematic to a spice netlist
+        // First export the schematic to a spice netlist. The netlist is
+        // kept from one simulation to the next, so that only the changes
+        // made in between must be exported again.
         if(info.suffix() == "xsch") {
-            FormatSpice *format = new FormatSpice(this);
-            format->save();
+            if(!m_spiceFormat) {
+                m_spiceFormat = new FormatSpice(this);
+            }
+            m_spiceFormat->save();
         }
 
-        // Invoke a spice simulator in batch mode
+        // Remove the results of any previous simulation, to avoid displaying
+        // them as the results of this one. If they are open, they are closed
+        // first, as the raw file is memory mapped and can not be removed on
+        // some platforms. If the file still can not be removed, the waveforms
+        // are displayed only once the simulation finishes.
         Settings *settings = Settings::instance();
+        bool liveWaveforms = settings->currentValue("sim/liveWaveforms").toBool();
+        if(liveWaveforms) {
+            QString rawFile = QDir::toNativeSeparators(path + "/" + baseName + ".raw");
+
+            DocumentViewManager *manager = DocumentViewManager::instance();
+            IDocument *previousResults = manager->documentForFileName(rawFile);
+            if(previousResults) {
+                manager->closeDocuments(QList<IDocument*>() << previousResults, false);
+            }
+
+            if(QFile::exists(rawFile) && !QFile::remove(rawFile)) {
+                liveWaveforms = false;
+            }
+        }
+
+        // Invoke a spice simulator in batch mode
         QString simulationCommand = settings->currentValue("sim/simulationCommand").toString();
         simulationCommand.replace("%filename", baseName);  // Replace all ocurrencies of %filename by the actual filename
 
@@ -833,6 +861,11 @@ namespace Caneda
 
         // The simulation results are opened in the simulationReady slot, to avoid blocking the interface while simulating
         connect(simulationProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(simulationReady(int)));
+
+        // Display the waveforms while the simulation is running, as soon as the simulator writes them
+        if(liveWaveforms) {
+            m_liveWaveformsTimer->start(250);
+        }
     }
 
     void SchematicDocument::print(QPrinter *printer, bool fitInView)
@@ -954,11 +987,27 @@ namespace Caneda
      */
     void SchematicDocument::simulationReady(int error)
     {
+        DocumentViewManager *manager = DocumentViewManager::instance();
+
+        QFileInfo info(fileName());
+        QString path = info.path();
+        QString baseName = info.completeBaseName();
+        QString rawFile = QDir::toNativeSeparators(path + "/" + baseName + ".raw");
+
+        // If the waveforms were displayed while simulating, read the last
+        // data written by the simulator instead of opening the file again.
+        m_liveWaveformsTimer->stop();
+        SimulationDocument *liveDocument =
+                qobject_cast<SimulationDocument*>(manager->documentForFileName(rawFile));
+        const bool live = liveDocument && liveDocument->isFollowing();
+        if(live) {
+            liveDocument->stopFollowing();
+        }
+
         // Test for errors, and open log file (in case something went wrong).
         // If there was an error, do not display the waveforms
         if(error) {
 
-            DocumentViewManager *manager = DocumentViewManager::instance();
             IView *view = manager->currentView();
 
             MessageWidget *dialog = new MessageWidget("There was an error during the simulation...", view->toWidget());
@@ -978,13 +1027,59 @@ namespace Caneda
         }
 
         // Open the resulting waveforms
-        DocumentViewManager *manager = DocumentViewManager::instance();
+        if(!live) {
+            manager->openFile(rawFile);
+        }
+    }
 
+    /*!
+     * \brief Opens the waveforms of the running simulation, once the
+     * simulator has written the header of the first plot.
+     *
+     * The opened document follows the raw file, displaying the waveforms
+     * while they are being simulated, until simulationReady() is called.
+     *
+     * \sa simulate(), SimulationDocument::startFollowing()
+     */
+    void SchematicDocument::openLiveWaveforms()
+    {
         QFileInfo info(fileName());
         QString path = info.path();
         QString baseName = info.completeBaseName();
+        QString rawFile = QDir::toNativeSeparators(path + "/" + baseName + ".raw");
+
+        // Wait for the line preceding the data of the first plot
+        QFile file(rawFile);
+        if(!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+
+        bool dataFound = false;
+        while(!file.atEnd() && !dataFound) {
+            QByteArray line = file.readLine();
+            if(!line.endsWith('\n')) {
+                break;  // Line not yet completely written
+            }
+
+            line = line.trimmed().toLower();
+            dataFound = (line == "values:" || line == "binary:");
+        }
+        file.close();
 
-        manager->openFile(QDir::toNativeSeparators(path + "/" + baseName + ".raw"));
+        if(!dataFound) {
+            return;
+        }
+
+        m_liveWaveformsTimer->stop();
+
+        DocumentViewManager *manager = DocumentViewManager::instance();
+        manager->openFile(rawFile);
+
+        SimulationDocument *document =
+                qobject_cast<SimulationDocument*>(manager->documentForFileName(rawFile));
+        if(document) {
+            document->startFollowing();
+        }
     }
 
     /*!
@@ -1185,7 +1280,9 @@ namespace Caneda
      *                         SimulationDocument                            *
      *************************************************************************/
     //! \brief Constructor.
-    SimulationDocument::SimulationDocument(QObject *parent) : IDocument(parent)
+    SimulationDocument::SimulationDocument(QObject *parent) :
+        IDocument(parent),
+        m_format(0)
     {
         m_chartScene = new ChartScene;
     }
@@ -1269,8 +1366,8 @@ namespace Caneda
         QFileInfo info(fileName());
 
         if(info.suffix() == "raw") {
-            FormatRawSimulation *format = new FormatRawSimulation(this);
-            return format->load();
+            m_format = new FormatRawSimulation(this);
+            return m_format->load();
         }
 
         if (errorMessage) {
@@ -1285,6 +1382,58 @@ namespace Caneda
         return new SimulationView(this);
     }
 
+    /*!
+     * \brief Displays \a plot of the simulation results.
+     *
+     * The data of the plot is read from the raw file the first time the plot
+     * is selected, and then all views are updated to display it.
+     *
+     * \sa FormatRawSimulation::loadPlot(), ChartScene::setCurrentPlot()
+     */
+    void SimulationDocument::setCurrentPlot(int plot)
+    {
+        if(m_format) {
+            m_format->loadPlot(plot);
+        }
+
+        m_chartScene->setCurrentPlot(plot);
+
+        // Refresh the list of curves of the sidebar
+        if(DocumentViewManager::instance()->currentDocument() == this) {
+            context()->updateSideBar();
+        }
+    }
+
+    /*!
+     * \brief Starts following the raw file while the simulator writes it.
+     *
+     * \sa FormatRawSimulation::startFollowing(), stopFollowing()
+     */
+    void SimulationDocument::startFollowing()
+    {
+        if(m_format) {
+            m_format->startFollowing();
+        }
+    }
+
+    /*!
+     * \brief Stops following the raw file, once the simulator finished.
+     *
+     * \sa FormatRawSimulation::stopFollowing(), startFollowing()
+     */
+    void SimulationDocument::stopFollowing()
+    {
+        if(m_format) {
+            m_format->stopFollowing();
+        }
+    }
+
+    //! \brief Returns true while the raw file is being followed.
+    bool SimulationDocument::isFollowing() const
+    {
+        return m_format && m_format->isFollowing();
+    }
+
     void SimulationDocument::launchPropertiesDialog()
     {
         DocumentViewManager *manager = DocumentViewManager::instance();
@@ -28,6 +28,7 @@
 class QPaintDevice;
 class QPrinter;
 class QTextDocument;
+class QTimer;
 
 namespace Caneda
 {
@@ -35,6 +36,8 @@ namespace Caneda
     class GraphicsScene;
     class ChartScene;
     class DocumentViewManager;
+    class FormatRawSimulation;
+    class FormatSpice;
     class IContext;
     class IView;
     class TextEdit;
@@ -289,9 +292,12 @@ namespace Caneda
         void simulationReady(int error);
         bool simulationError();
         void showSimulationHelp();
+        void openLiveWaveforms();
 
     private:
         GraphicsScene *m_graphicsScene;
+        FormatSpice *m_spiceFormat;    //! \brief Netlist kept up to date while editing.
+        QTimer *m_liveWaveformsTimer;  //! \brief Polls for the raw file while simulating.
 
         void alignElements(Qt::Alignment alignment);
         bool performBasicChecks();
@@ -371,8 +377,15 @@ namespace Caneda
 
         ChartScene* chartScene() const { return m_chartScene; }
 
+        void setCurrentPlot(int plot);
+
+        void startFollowing();
+        void stopFollowing();
+        bool isFollowing() const;
+
     private:
         ChartScene *m_chartScene;
+        FormatRawSimulation *m_format;  //! \brief Raw file being displayed, used to read plots on demand.
     };
 
     /*!
@@ -33,6 +33,7 @@
 #include <QPixmapCache>
 #include <QString>
 #include <QTextStream>
+#include <QtMath>
 
 namespace Caneda
 {
@@ -161,9 +162,18 @@ namespace Caneda
     /*************************************************************************
      *                           Library Manager                             *
      *************************************************************************/
+    //! \brief Memory budget (in kilobytes) of the zoomed symbol pixmaps cache.
+    static const int zoomPixmapCacheSize = 32768;
+
+    //! \brief Smallest zoom level at which symbol pixmaps are rendered.
+    static const qreal minimumPixmapZoom = 1.0 / 16;
+
     //! \brief Constructor.
-    LibraryManager::LibraryManager(QObject *parent) : QObject(parent)
+    LibraryManager::LibraryManager(QObject *parent) :
+        QObject(parent),
+        m_generation(0)
     {
+        m_zoomPixmapCache.setMaxCost(zoomPixmapCacheSize);
     }
 
     //! \copydoc MainWindow::instance()
@@ -189,6 +199,7 @@ namespace Caneda
 
         Library *info = new Library(libPath);
         m_libraryHash.insert(info->libraryName(), info);
+        ++m_generation;
         return true;
     }
 
@@ -212,6 +223,7 @@ namespace Caneda
         }
 
         m_libraryHash.insert(info->libraryName(), info);
+        ++m_generation;
         return true;
     }
 
@@ -220,6 +232,7 @@ namespace Caneda
     {
         if(m_libraryHash.contains(libName)) {
             m_libraryHash.remove(libName);
+            ++m_generation;
             return true;
         }
 
@@ -348,6 +361,71 @@ namespace Caneda
         return pix;
     }
 
+    /*!
+     * \brief Returns the cached pixmap of a component, rendered for the zoom
+     * level \a zoom and selection state \a selected.
+     *
+     * The zoom level is rounded up to the next half power of two, so that a
+     * few pixmaps cover all zoom levels and the pixmaps are always scaled
+     * down when drawn. The pixmap device pixel ratio is set to the rendered
+     * zoom level, so it is drawn with the size of the symbol in item
+     * coordinates.
+     *
+     * The pixmaps are kept in a least recently used cache with a fixed memory
+     * budget. The cache key also includes the colors and line width, so that
+     * pixmaps drawn with old settings are never used.
+     *
+     * \param compName Component name, used as part of the key
+     * \param libName Library name, used as part of the key
+     * \param zoom Zoom level at which the symbol will be drawn
+     * \param selected True to draw the symbol with the selection color
+     * \return QPixmap corresponding to the symbol
+     *
+     * \sa registerComponent(), symbolCache()
+     */
+    const QPixmap LibraryManager::pixmapCache(const QString &compName, const QString &libName,
+                                              qreal zoom, bool selected)
+    {
+        const RenderSettings &settings = Settings::instance()->renderSettings();
+        const QPen &pen = selected ? settings.selectionPen : settings.linePen;
+
+        // Quantize the zoom level
+        const int step = qCeil(2 * qLn(qMax(zoom, minimumPixmapZoom)) / M_LN2);
+        const qreal scale = qPow(2.0, step / 2.0);
+
+        const QString symbol_id = compName + ":" + libName;
+        const QString key = symbol_id + ":" + QString::number(step) + ":" +
+                QString::number(pen.color().rgba()) + ":" + QString::number(pen.width());
+
+        QPixmap *cached = m_zoomPixmapCache.object(key);
+        if(cached) {
+            return *cached;
+        }
+
+        QPainterPath data = m_dataHash[symbol_id];
+        QRect rect =  data.boundingRect().toRect();
+        rect.adjust(-1.0, -1.0, 1.0, 1.0); // Adjust rect to avoid clipping due to rounding (rectF -> rect)
+
+        QPixmap pix(qCeil(rect.width() * scale), qCeil(rect.height() * scale));
+        pix.fill(Qt::transparent);
+
+        QPainter painter(&pix);
+        painter.setRenderHints(Caneda::DefaulRenderHints);
+        painter.setPen(pen);
+        painter.scale(scale, scale);
+        painter.translate(-rect.topLeft());
+        painter.drawPath(data);
+        painter.end();
+
+        pix.setDevicePixelRatio(scale);
+
+        // The cost is the size of the pixmap in kilobytes
+        const int cost = pix.width() * pix.height() * pix.depth() / (8 * 1024) + 1;
+        m_zoomPixmapCache.insert(key, new QPixmap(pix), cost);
+
+        return pix;
+    }
+
     /*!
      * \brief Returns default component data given its name and library.
      *
@@ -23,7 +23,9 @@
 
 #include "component.h"
 
+#include <QCache>
 #include <QHash>
+#include <QPixmap>
 
 namespace Caneda
 {
@@ -102,12 +104,16 @@ namespace Caneda
         Library* library(const QString& libName) const;
         //! Returns the libraries list.
         const QList<QString> librariesList() const { return m_libraryHash.uniqueKeys(); }
+        //! Returns a number changed each time the loaded libraries change.
+        int generation() const { return m_generation; }
 
         // Symbol caching related methods
         void registerComponent(const QString &compName, const QString &libName, const QPainterPath& content);
 
         QPainterPath symbolCache(const QString &compName, const QString &libName);
         const QPixmap pixmapCache(const QString &compName, const QString &libName);
+        const QPixmap pixmapCache(const QString &compName, const QString &libName,
+                                  qreal zoom, bool selected);
 
         ComponentDataPtr componentData(QString name, QString library);
 
@@ -116,9 +122,14 @@ namespace Caneda
 
         //! Hash table to hold libraries.
         QHash<QString, Library*> m_libraryHash;
+        //! Number of times a library was created, loaded or unloaded.
+        int m_generation;
 
         //! Symbol cache (hash table) to hold symbol's QPainterPaths.
         QHash<QString, QPainterPath> m_dataHash;
+
+        //! Least recently used cache of symbol's pixmaps at several zoom levels.
+        QCache<QString, QPixmap> m_zoomPixmapCache;
     };
 
 } // namespace Caneda
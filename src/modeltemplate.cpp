@@ -0,0 +1,210 @@
+/***************************************************************************
+ * Copyright (C) 2016 by Pablo Daniel Pareja Obregon                       *
+ *                                                                         *
+ * This is free software; you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 2, or (at your option)     *
+ * any later version.                                                      *
+ *                                                                         *
+ * This software is distributed in the hope that it will be useful,        *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this package; see the file COPYING.  If not, write to        *
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,   *
+ * Boston, MA 02110-1301, USA.                                             *
+ ***************************************************************************/
+
+#include "modeltemplate.h"
+
+#include <QStringList>
+
+namespace Caneda
+{
+    /*!
+     * \brief Returns true if \a keyword is found in \a syntax at \a pos.
+     */
+    static bool matchesKeyword(const QString &syntax, int pos, const QLatin1String &keyword)
+    {
+        return syntax.midRef(pos, keyword.size()) == keyword;
+    }
+
+    /*!
+     * \brief Constructs a model template by parsing the model \a syntax.
+     *
+     * \sa \ref ModelsFormat
+     */
+    ModelTemplate::ModelTemplate(const QString &syntax) :
+        m_sizeHint(syntax.size())
+    {
+        int pos = 0;
+        m_tokens = parse(syntax, pos, false);
+    }
+
+    /*!
+     * \brief Parses the model syntax starting at \a pos.
+     *
+     * When parsing the arguments of an escape sequence (\a nested), parsing
+     * stops at the closing bracket of the sequence, leaving \a pos on it.
+     * Brackets not belonging to an escape sequence (for example spice
+     * parameters inside a subcircuit) are kept balanced and copied "as is".
+     */
+    QList<ModelToken> ModelTemplate::parse(const QString &syntax, int &pos, bool nested)
+    {
+        QList<ModelToken> tokens;
+        QString literal;
+        int depth = 0;
+
+        while(pos < syntax.size()) {
+            const QChar c = syntax.at(pos);
+
+            if(nested && c == QLatin1Char('}')) {
+                if(depth == 0) {
+                    break;
+                }
+                --depth;
+            }
+            else if(nested && c == QLatin1Char('{')) {
+                ++depth;
+            }
+
+            if(c != QLatin1Char('%')) {
+                literal.append(c);
+                ++pos;
+                continue;
+            }
+
+            // Escape sequences without arguments
+            ModelToken::Type type = ModelToken::Literal;
+            int length = 0;
+
+            if(matchesKeyword(syntax, pos, QLatin1String("%label"))) {
+                type = ModelToken::Label;
+                length = 6;
+            }
+            else if(matchesKeyword(syntax, pos, QLatin1String("%librarypath"))) {
+                type = ModelToken::LibraryPath;
+                length = 12;
+            }
+            else if(matchesKeyword(syntax, pos, QLatin1String("%filepath"))) {
+                type = ModelToken::FilePath;
+                length = 9;
+            }
+            else if(matchesKeyword(syntax, pos, QLatin1String("%generateNetlist"))) {
+                type = ModelToken::GenerateNetlist;
+                length = 16;
+            }
+
+            if(length > 0) {
+                appendLiteral(tokens, literal);
+                tokens << ModelToken(type);
+                pos += length;
+                continue;
+            }
+
+            // Escape sequences with arguments
+            if(matchesKeyword(syntax, pos, QLatin1String("%port{"))) {
+                type = ModelToken::Port;
+                length = 6;
+            }
+            else if(matchesKeyword(syntax, pos, QLatin1String("%property{"))) {
+                type = ModelToken::Property;
+                length = 10;
+            }
+            else if(matchesKeyword(syntax, pos, QLatin1String("%if{"))) {
+                type = ModelToken::If;
+                length = 4;
+            }
+            else if(matchesKeyword(syntax, pos, QLatin1String("%model{"))) {
+                type = ModelToken::Model;
+                length = 7;
+            }
+            else if(matchesKeyword(syntax, pos, QLatin1String("%subcircuit{"))) {
+                type = ModelToken::Subcircuit;
+                length = 12;
+            }
+            else if(matchesKeyword(syntax, pos, QLatin1String("%directive{"))) {
+                type = ModelToken::Directive;
+                length = 11;
+            }
+
+            if(length > 0) {
+                appendLiteral(tokens, literal);
+                pos += length;
+
+                ModelToken token(type);
+                token.arguments = parse(syntax, pos, true);
+                if(type == ModelToken::If) {
+                    splitCondition(token);
+                }
+                tokens << token;
+
+                // Skip the closing bracket
+                ++pos;
+                continue;
+            }
+
+            // New line or unknown escape sequence, copied "as is"
+            if(matchesKeyword(syntax, pos, QLatin1String("%n"))) {
+                literal.append(QLatin1Char('\n'));
+                pos += 2;
+            }
+            else {
+                literal.append(c);
+                ++pos;
+            }
+        }
+
+        appendLiteral(tokens, literal);
+        return tokens;
+    }
+
+    //! \brief Adds the pending \a literal text (if any) to \a tokens.
+    void ModelTemplate::appendLiteral(QList<ModelToken> &tokens, QString &literal)
+    {
+        if(!literal.isEmpty()) {
+            tokens << ModelToken(ModelToken::Literal, literal);
+            literal.clear();
+        }
+    }
+
+    /*!
+     * \brief Splits the arguments of an %if sequence.
+     *
+     * The arguments are split in the condition (kept as arguments) and the
+     * true value, by looking for the separating commas in the literal text.
+     * Any text after a second comma is discarded.
+     */
+    void ModelTemplate::splitCondition(ModelToken &token)
+    {
+        QList<ModelToken> condition;
+        QList<ModelToken> trueValue;
+        QList<ModelToken> *current = &condition;
+
+        foreach(const ModelToken &argument, token.arguments) {
+            if(argument.type != ModelToken::Literal) {
+                *current << argument;
+                continue;
+            }
+
+            QStringList parts = argument.text.split(QLatin1Char(','));
+            for(int i = 0; i < parts.size(); ++i) {
+                if(i > 0) {
+                    if(current == &trueValue) {
+                        token.arguments = condition;
+                        token.trueValue = trueValue;
+                        return;
+                    }
+                    current = &trueValue;
+                }
+                appendLiteral(*current, parts[i]);
+            }
+        }
+
+        token.arguments = condition;
+        token.trueValue = trueValue;
+    }
+
+} // namespace Caneda
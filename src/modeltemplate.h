@@ -0,0 +1,96 @@
+/***************************************************************************
+ * Copyright (C) 2016 by Pablo Daniel Pareja Obregon                       *
+ *                                                                         *
+ * This is free software; you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 2, or (at your option)     *
+ * any later version.                                                      *
+ *                                                                         *
+ * This software is distributed in the hope that it will be useful,        *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this package; see the file COPYING.  If not, write to        *
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,   *
+ * Boston, MA 02110-1301, USA.                                             *
+ ***************************************************************************/
+
+#ifndef MODEL_TEMPLATE_H
+#define MODEL_TEMPLATE_H
+
+#include <QList>
+#include <QString>
+
+namespace Caneda
+{
+    /*!
+     * \brief Single element of a parsed model syntax.
+     *
+     * Escape sequences with arguments keep their already parsed arguments as
+     * nested tokens, allowing cascaded sequences (for example a property
+     * inside a model) to be resolved while walking the token tree.
+     *
+     * \sa ModelTemplate, \ref ModelsFormat
+     */
+    struct ModelToken
+    {
+        //! \brief Kind of text or escape sequence represented by the token.
+        enum Type {
+            Literal,         //!< Text copied "as is", including %n newlines.
+            Label,           //!< %label
+            LibraryPath,     //!< %librarypath
+            FilePath,        //!< %filepath
+            GenerateNetlist, //!< %generateNetlist
+            Port,            //!< %port{name}
+            Property,        //!< %property{name}
+            If,              //!< %if{condition,true_value}
+            Model,           //!< %model{definition}
+            Subcircuit,      //!< %subcircuit{definition}
+            Directive        //!< %directive{definition}
+        };
+
+        explicit ModelToken(Type t = Literal, const QString &s = QString()) :
+            type(t), text(s) {}
+
+        Type type;
+        QString text;                  //!< \brief Literal text.
+        QList<ModelToken> arguments;   //!< \brief Argument (condition for %if).
+        QList<ModelToken> trueValue;   //!< \brief True value of %if.
+    };
+
+    /*!
+     * \brief Model syntax parsed into a list of tokens.
+     *
+     * Parsing the model syntax of a component is done only once, when the
+     * component is loaded into a library, and the resulting template is
+     * shared by all components of the same kind. Exporting a component then
+     * only needs to walk the tokens, instead of searching the escape
+     * sequences in the syntax string for every component.
+     *
+     * \sa ModelToken, ComponentData, \ref ModelsFormat
+     */
+    class ModelTemplate
+    {
+    public:
+        ModelTemplate() : m_sizeHint(0) {}
+        explicit ModelTemplate(const QString &syntax);
+
+        //! Returns the parsed tokens.
+        const QList<ModelToken>& tokens() const { return m_tokens; }
+        //! Returns the length of the original syntax, used as size hint.
+        int sizeHint() const { return m_sizeHint; }
+
+    private:
+        static QList<ModelToken> parse(const QString &syntax, int &pos, bool nested);
+        static void appendLiteral(QList<ModelToken> &tokens, QString &literal);
+        static void splitCondition(ModelToken &token);
+
+        QList<ModelToken> m_tokens;
+        int m_sizeHint;
+    };
+
+} // namespace Caneda
+
+#endif //MODEL_TEMPLATE_H
@@ -72,9 +72,8 @@ namespace Caneda
             QWidget *w)
     {
         if(option->state & QStyle::State_Selected) {
-            Settings *settings = Settings::instance();
-            painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>(),
-                                 pen().width()));
+            const RenderSettings &settings = Settings::instance()->renderSettings();
+            painter->setPen(QPen(settings.selectionColor, pen().width()));
 
             painter->setBrush(Qt::NoBrush);
         }
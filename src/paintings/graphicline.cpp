@@ -55,9 +55,8 @@ namespace Caneda
     void GraphicLine::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *w)
     {
         if(option->state & QStyle::State_Selected) {
-            Settings *settings = Settings::instance();
-            painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>(),
-                                 pen().width()));
+            const RenderSettings &settings = Settings::instance()->renderSettings();
+            painter->setPen(QPen(settings.selectionColor, pen().width()));
         }
         else {
             painter->setPen(pen());
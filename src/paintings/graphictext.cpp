@@ -96,9 +96,8 @@ namespace Caneda
             const QPen savePen = painter->pen();
 
             // Draw selection rectangle
-            Settings *settings = Settings::instance();
-            painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt(), Qt::DashLine));
+            const RenderSettings &settings = Settings::instance()->renderSettings();
+            painter->setPen(QPen(settings.selectionColor, settings.lineWidth, Qt::DashLine));
             painter->drawRect(boundingRect());
 
             // Restore pen
@@ -370,8 +370,8 @@ namespace Caneda
         QPen savedPen = painter->pen();
         QBrush savedBrush = painter->brush();
 
-        Settings *settings = Settings::instance();
-        painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>()));
+        const RenderSettings &settings = Settings::instance()->renderSettings();
+        painter->setPen(QPen(settings.selectionColor));
         painter->setBrush(Qt::NoBrush);
 
         // handleRect is defined as QRectF(-w/2, -h/2, w, h)
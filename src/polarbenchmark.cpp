@@ -0,0 +1,146 @@
+/***************************************************************************
+ * Copyright (C) 2016 by Pablo Daniel Pareja Obregon                       *
+ *                                                                         *
+ * This is free software; you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 2, or (at your option)     *
+ * any later version.                                                      *
+ *                                                                         *
+ * This software is distributed in the hope that it will be useful,        *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this package; see the file COPYING.  If not, write to        *
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,   *
+ * Boston, MA 02110-1301, USA.                                             *
+ ***************************************************************************/
+
+#include "chartitem.h"
+#include "polarconversion.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtMath>
+#include <qnumeric.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Caneda
+{
+    /*!
+     * \brief Scalar conversion used before the vectorized kernel, kept as
+     * the reference for timing and accuracy.
+     *
+     * \sa complexToPolar()
+     */
+    void scalarComplexToPolar(const uchar *src, int stride, double *magnitude,
+                              double *phase, int count)
+    {
+        for(int i = 0; i < count; i++){
+            double real = ChartSampleStore::readMapped(src);
+            double imaginary = ChartSampleStore::readMapped(src + sizeof(double));
+            src += stride;
+
+            magnitude[i] = 20*log10(qSqrt(real*real + imaginary*imaginary));
+            phase[i] = qAtan(imaginary/real) * 180/M_PI;
+        }
+    }
+
+    //! \brief Returns true if both values are equal within a relative tolerance.
+    bool agrees(double value, double reference)
+    {
+        if(qIsNaN(reference)) {
+            return qIsNaN(value);
+        }
+        if(qIsInf(reference)) {
+            return value == reference;
+        }
+
+        return qAbs(value - reference) <= 1e-12 * qMax(1.0, qAbs(reference));
+    }
+
+    //! \brief Returns the best time in milliseconds of several conversions.
+    double bestTime(void (*convert)(const uchar *, int, double *, double *, int),
+                    const QByteArray &samples, QVector<double> &magnitude,
+                    QVector<double> &phase, int repeats)
+    {
+        const int count = magnitude.size();
+        const uchar *src = reinterpret_cast<const uchar *>(samples.constData());
+        qint64 best = -1;
+
+        for(int i = 0; i < repeats; i++) {
+            QElapsedTimer timer;
+            timer.start();
+            convert(src, 2*sizeof(double), magnitude.data(), phase.data(), count);
+            qint64 elapsed = timer.nsecsElapsed();
+            if(best < 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+
+        return best / 1e6;
+    }
+
+} // namespace Caneda
+
+using namespace Caneda;
+
+/*!
+ * \brief Times complexToPolar() against the previous scalar loop.
+ *
+ * Usage: polarbenchmark [points] [repeats]. Returns a non zero exit code if
+ * any converted value differs from the scalar result.
+ */
+int main(int argc, char *argv[])
+{
+    const int count = argc > 1 ? atoi(argv[1]) : 4*1024*1024;
+    const int repeats = argc > 2 ? atoi(argv[2]) : 10;
+    if(count <= 0 || repeats <= 0) {
+        fprintf(stderr, "Usage: %s [points] [repeats]\n", argv[0]);
+        return 2;
+    }
+
+    // Interleaved real and imaginary parts, as in the mapped raw files. A
+    // few special values are included to exercise the scalar fallback.
+    QByteArray samples(count * 2 * int(sizeof(double)), 0);
+    double *values = reinterpret_cast<double *>(samples.data());
+    srand(1);
+    for(int i = 0; i < 2*count; i++) {
+        values[i] = (rand() / double(RAND_MAX) - 0.5) * qPow(10.0, rand() % 13 - 6);
+    }
+    if(count > 3) {
+        values[0] = 0.0;
+        values[1] = 0.0;
+        values[2] = -1.0;
+        values[5] = 1e-310;
+        values[6] = qInf();
+    }
+
+    QVector<double> refMagnitude(count), refPhase(count);
+    QVector<double> magnitude(count), phase(count);
+
+    double scalarTime = bestTime(scalarComplexToPolar, samples, refMagnitude, refPhase, repeats);
+    double kernelTime = bestTime(complexToPolar, samples, magnitude, phase, repeats);
+
+    int mismatches = 0;
+    for(int i = 0; i < count; i++) {
+        if(!agrees(magnitude[i], refMagnitude[i]) || !agrees(phase[i], refPhase[i])) {
+            if(mismatches++ < 10) {
+                fprintf(stderr, "Mismatch at %d: %.17g %.17g, expected %.17g %.17g\n",
+                        i, magnitude[i], phase[i], refMagnitude[i], refPhase[i]);
+            }
+        }
+    }
+
+    printf("%d points, best of %d runs\n", count, repeats);
+    printf("scalar loop:    %10.3f ms\n", scalarTime);
+    printf("complexToPolar: %10.3f ms (%.2fx)\n", kernelTime, scalarTime / kernelTime);
+    printf("%d mismatches\n", mismatches);
+
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+/***************************************************************************
+ * Copyright (C) 2016 by Pablo Daniel Pareja Obregon                       *
+ *                                                                         *
+ * This is free software; you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 2, or (at your option)     *
+ * any later version.                                                      *
+ *                                                                         *
+ * This software is distributed in the hope that it will be useful,        *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this package; see the file COPYING.  If not, write to        *
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,   *
+ * Boston, MA 02110-1301, USA.                                             *
+ ***************************************************************************/
+
+#include "polarconversion.h"
+
+#include "chartitem.h"
+#include "polarkernel.h"
+
+#include <QtMath>
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN && (defined(__SSE2__) || defined(_M_X64))
+#define CANEDA_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Caneda
+{
+#ifdef CANEDA_HAVE_SSE2
+    //! \brief Vector operations on two doubles, for PolarKernel::convert().
+    struct Sse2Ops
+    {
+        typedef __m128d Vector;
+        enum { Width = 2 };
+
+        static inline Vector set1(double value) { return _mm_set1_pd(value); }
+
+        static inline Vector add(Vector a, Vector b) { return _mm_add_pd(a, b); }
+        static inline Vector sub(Vector a, Vector b) { return _mm_sub_pd(a, b); }
+        static inline Vector mul(Vector a, Vector b) { return _mm_mul_pd(a, b); }
+        static inline Vector div(Vector a, Vector b) { return _mm_div_pd(a, b); }
+
+        static inline Vector bitAnd(Vector a, Vector b) { return _mm_and_pd(a, b); }
+        static inline Vector bitAndNot(Vector a, Vector b) { return _mm_andnot_pd(a, b); }
+        static inline Vector bitOr(Vector a, Vector b) { return _mm_or_pd(a, b); }
+        static inline Vector bitXor(Vector a, Vector b) { return _mm_xor_pd(a, b); }
+        static inline Vector select(Vector mask, Vector a, Vector b) { return bitOr(bitAnd(mask, a), bitAndNot(mask, b)); }
+
+        static inline Vector lessThan(Vector a, Vector b) { return _mm_cmplt_pd(a, b); }
+        static inline Vector lessEqual(Vector a, Vector b) { return _mm_cmple_pd(a, b); }
+        static inline Vector greaterThan(Vector a, Vector b) { return _mm_cmpgt_pd(a, b); }
+        static inline Vector greaterEqual(Vector a, Vector b) { return _mm_cmpge_pd(a, b); }
+        static inline bool all(Vector mask) { return _mm_movemask_pd(mask) == 0x3; }
+
+        //! \brief Returns e, with x = m * 2^e and m in [0.5, 1), for positive normal values.
+        static inline Vector exponent(Vector x)
+        {
+            __m128i bits = _mm_srli_epi64(_mm_castpd_si128(x), 52);
+            bits = _mm_or_si128(bits, _mm_set1_epi64x(0x4330000000000000LL));  // 2^52 + biased exponent
+            return _mm_sub_pd(_mm_castsi128_pd(bits), _mm_set1_pd(4503599627370496.0 + 1022));
+        }
+
+        //! \brief Returns m, with x = m * 2^e and m in [0.5, 1), for positive normal values.
+        static inline Vector mantissa(Vector x)
+        {
+            __m128i bits = _mm_and_si128(_mm_castpd_si128(x), _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+            bits = _mm_or_si128(bits, _mm_set1_epi64x(0x3FE0000000000000LL));
+            return _mm_castsi128_pd(bits);
+        }
+
+        //! \brief Loads two complex numbers, splitting the real and imaginary parts.
+        static inline void loadComplex(const uchar *src, int stride, Vector &real, Vector &imaginary)
+        {
+            const Vector z0 = _mm_loadu_pd(reinterpret_cast<const double*>(src));
+            const Vector z1 = _mm_loadu_pd(reinterpret_cast<const double*>(src + stride));
+            real = _mm_unpacklo_pd(z0, z1);
+            imaginary = _mm_unpackhi_pd(z0, z1);
+        }
+
+        static inline void store(double *dst, Vector value) { _mm_storeu_pd(dst, value); }
+    };
+#endif
+
+    /*!
+     * \brief Converts complex numbers into magnitude (in dB) and phase.
+     *
+     * The conversion is done by the widest vector kernel supported by the
+     * processor (AVX2 or SSE2, see PolarKernel), falling back to scalar code
+     * on other architectures or on big endian hosts.
+     *
+     * \param src Address of the first complex number, stored as a pair of
+     * 64 bit floats (real and imaginary parts), in the format of the mapped
+     * raw file (see ChartSampleStore::readMapped()).
+     * \param stride Distance in bytes between consecutive complex numbers.
+     * \param magnitude Output array for the magnitude, in dB (20*log10(V)).
+     * \param phase Output array for the phase, in degrees.
+     * \param count Number of complex numbers to convert.
+     */
+    void complexToPolar(const uchar *src, int stride, double *magnitude,
+                        double *phase, int count)
+    {
+#if defined(CANEDA_HAVE_AVX2) && defined(CANEDA_HAVE_SSE2) && defined(__GNUC__)
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        if(avx2) {
+            PolarKernel::convertAvx2(src, stride, magnitude, phase, count);
+            return;
+        }
+#endif
+
+#ifdef CANEDA_HAVE_SSE2
+        PolarKernel::convert<Sse2Ops>(src, stride, magnitude, phase, count);
+#else
+        for(int i = 0; i < count; i++){
+            double real = ChartSampleStore::readMapped(src);  // Get the real part
+            double imaginary = ChartSampleStore::readMapped(src + sizeof(double));  // Get the imaginary part
+            src += stride;
+
+            magnitude[i] = 20*log10(qSqrt(real*real + imaginary*imaginary));  // Calculate the magnitude part
+            phase[i] = qAtan(imaginary/real) * 180/M_PI;  // Calculate the phase part
+        }
+#endif
+    }
+
+} // namespace Caneda
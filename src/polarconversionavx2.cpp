@@ -0,0 +1,98 @@
+/***************************************************************************
+ * Copyright (C) 2016 by Pablo Daniel Pareja Obregon                       *
+ *                                                                         *
+ * This is free software; you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 2, or (at your option)     *
+ * any later version.                                                      *
+ *                                                                         *
+ * This software is distributed in the hope that it will be useful,        *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this package; see the file COPYING.  If not, write to        *
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,   *
+ * Boston, MA 02110-1301, USA.                                             *
+ ***************************************************************************/
+
+#include "polarkernel.h"
+
+#include <immintrin.h>
+
+namespace Caneda
+{
+    /*!
+     * \brief Vector operations on four doubles, for PolarKernel::convert().
+     *
+     * This file is compiled with AVX2 code generation enabled, and its code
+     * is only called after checking the processor supports it.
+     *
+     * \sa Sse2Ops
+     */
+    struct Avx2Ops
+    {
+        typedef __m256d Vector;
+        enum { Width = 4 };
+
+        static inline Vector set1(double value) { return _mm256_set1_pd(value); }
+
+        static inline Vector add(Vector a, Vector b) { return _mm256_add_pd(a, b); }
+        static inline Vector sub(Vector a, Vector b) { return _mm256_sub_pd(a, b); }
+        static inline Vector mul(Vector a, Vector b) { return _mm256_mul_pd(a, b); }
+        static inline Vector div(Vector a, Vector b) { return _mm256_div_pd(a, b); }
+
+        static inline Vector bitAnd(Vector a, Vector b) { return _mm256_and_pd(a, b); }
+        static inline Vector bitAndNot(Vector a, Vector b) { return _mm256_andnot_pd(a, b); }
+        static inline Vector bitOr(Vector a, Vector b) { return _mm256_or_pd(a, b); }
+        static inline Vector bitXor(Vector a, Vector b) { return _mm256_xor_pd(a, b); }
+        static inline Vector select(Vector mask, Vector a, Vector b) { return _mm256_blendv_pd(b, a, mask); }
+
+        static inline Vector lessThan(Vector a, Vector b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+        static inline Vector lessEqual(Vector a, Vector b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+        static inline Vector greaterThan(Vector a, Vector b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+        static inline Vector greaterEqual(Vector a, Vector b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+        static inline bool all(Vector mask) { return _mm256_movemask_pd(mask) == 0xF; }
+
+        //! \brief Returns e, with x = m * 2^e and m in [0.5, 1), for positive normal values.
+        static inline Vector exponent(Vector x)
+        {
+            __m256i bits = _mm256_srli_epi64(_mm256_castpd_si256(x), 52);
+            bits = _mm256_or_si256(bits, _mm256_set1_epi64x(0x4330000000000000LL));  // 2^52 + biased exponent
+            return _mm256_sub_pd(_mm256_castsi256_pd(bits), _mm256_set1_pd(4503599627370496.0 + 1022));
+        }
+
+        //! \brief Returns m, with x = m * 2^e and m in [0.5, 1), for positive normal values.
+        static inline Vector mantissa(Vector x)
+        {
+            __m256i bits = _mm256_and_si256(_mm256_castpd_si256(x), _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+            bits = _mm256_or_si256(bits, _mm256_set1_epi64x(0x3FE0000000000000LL));
+            return _mm256_castsi256_pd(bits);
+        }
+
+        //! \brief Loads four complex numbers, splitting the real and imaginary parts.
+        static inline void loadComplex(const unsigned char *src, int stride, Vector &real, Vector &imaginary)
+        {
+            const __m128d z0 = _mm_loadu_pd(reinterpret_cast<const double*>(src));
+            const __m128d z1 = _mm_loadu_pd(reinterpret_cast<const double*>(src + stride));
+            const __m128d z2 = _mm_loadu_pd(reinterpret_cast<const double*>(src + 2*stride));
+            const __m128d z3 = _mm_loadu_pd(reinterpret_cast<const double*>(src + 3*stride));
+
+            const Vector even = _mm256_insertf128_pd(_mm256_castpd128_pd256(z0), z2, 1);  // re0 im0 re2 im2
+            const Vector odd = _mm256_insertf128_pd(_mm256_castpd128_pd256(z1), z3, 1);   // re1 im1 re3 im3
+            real = _mm256_unpacklo_pd(even, odd);
+            imaginary = _mm256_unpackhi_pd(even, odd);
+        }
+
+        static inline void store(double *dst, Vector value) { _mm256_storeu_pd(dst, value); }
+    };
+
+    //! \brief Converts complex numbers using AVX2 instructions.
+    void PolarKernel::convertAvx2(const unsigned char *src, int stride, double *magnitude,
+                                  double *phase, int count)
+    {
+        convert<Avx2Ops>(src, stride, magnitude, phase, count);
+    }
+
+} // namespace Caneda
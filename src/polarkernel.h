@@ -0,0 +1,222 @@
+/***************************************************************************
+ * Copyright (C) 2016 by Pablo Daniel Pareja Obregon                       *
+ *                                                                         *
+ * This is free software; you can redistribute it and/or modify            *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 2, or (at your option)     *
+ * any later version.                                                      *
+ *                                                                         *
+ * This software is distributed in the hope that it will be useful,        *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this package; see the file COPYING.  If not, write to        *
+ * the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,   *
+ * Boston, MA 02110-1301, USA.                                             *
+ ***************************************************************************/
+
+#ifndef POLAR_KERNEL_H
+#define POLAR_KERNEL_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace Caneda
+{
+    /*!
+     * \brief Vectorized conversion of complex numbers into magnitude (in dB)
+     * and phase (in degrees).
+     *
+     * The conversion is written once, as a template over a set of vector
+     * operations (Ops), and instantiated for each supported instruction set
+     * (see polarconversion.cpp). Each instantiation processes Ops::Width
+     * complex numbers at a time, computing in a single pass:
+     *
+     * \li The magnitude as 10*log10(re^2 + im^2), which equals
+     * 20*log10(sqrt(re^2 + im^2)) without the square root.
+     * \li The phase as atan(im/re), folding the division into the range
+     * reduction of the arctangent.
+     *
+     * The logarithm and arctangent use the rational approximations of the
+     * Cephes math library, accurate to double precision. Groups with zero,
+     * subnormal, infinite or NaN magnitudes are handled by the scalar code, as
+     * they are rare and would otherwise complicate the vector code.
+     *
+     * The input is read in the format of a little endian binary raw file, so
+     * the vector code is only used on little endian hosts.
+     *
+     * \sa complexToPolar()
+     */
+    namespace PolarKernel
+    {
+        //! \brief Converts one complex number, stored in native byte order.
+        inline void convert(const unsigned char *src, double *magnitude, double *phase)
+        {
+            double real;
+            double imaginary;
+            memcpy(&real, src, sizeof(double));
+            memcpy(&imaginary, src + sizeof(double), sizeof(double));
+
+            *magnitude = 20*std::log10(std::sqrt(real*real + imaginary*imaginary));
+            *phase = std::atan(imaginary/real) * 180/M_PI;
+        }
+
+        //! \brief Evaluates the polynomial with \a N coefficients \a c at \a x.
+        template<class Ops, int N>
+        inline typename Ops::Vector polynomial(typename Ops::Vector x, const double (&c)[N])
+        {
+            typename Ops::Vector result = Ops::set1(c[0]);
+            for(int i = 1; i < N; ++i) {
+                result = Ops::add(Ops::mul(result, x), Ops::set1(c[i]));
+            }
+            return result;
+        }
+
+        /*!
+         * \brief Natural logarithm of positive, normal and finite values.
+         *
+         * The value is split into x = m * 2^e, with m between sqrt(1/2) and
+         * sqrt(2), and log(m) is approximated by a rational function.
+         */
+        template<class Ops>
+        inline typename Ops::Vector log(typename Ops::Vector x)
+        {
+            typedef typename Ops::Vector Vector;
+
+            static const double P[] = {
+                1.01875663804580931796E-4, 4.97494994976747001425E-1,
+                4.70579119878881725854E0,  1.44989225341610930846E1,
+                1.79368678507819816313E1,  7.70838733755885391666E0
+            };
+            static const double Q[] = {
+                1.0,                       1.12873587189167450590E1,
+                4.52279145837532221105E1,  8.29875266912776603211E1,
+                7.11544750618563894466E1,  2.31251620126765340583E1
+            };
+
+            Vector e = Ops::exponent(x);  // x = m * 2^e, with m in [0.5, 1)
+            Vector m = Ops::mantissa(x);
+
+            // Move m into [sqrt(1/2), sqrt(2)), and subtract one
+            const Vector one = Ops::set1(1.0);
+            const Vector small = Ops::lessThan(m, Ops::set1(0.70710678118654752440));
+            e = Ops::sub(e, Ops::bitAnd(small, one));
+            m = Ops::sub(Ops::add(m, Ops::bitAnd(small, m)), one);
+
+            const Vector z = Ops::mul(m, m);
+            Vector y = Ops::mul(m, Ops::mul(z, Ops::div(polynomial<Ops>(m, P),
+                                                        polynomial<Ops>(m, Q))));
+            y = Ops::sub(y, Ops::mul(e, Ops::set1(2.121944400546905827679E-4)));
+            y = Ops::sub(y, Ops::mul(z, Ops::set1(0.5)));
+
+            return Ops::add(Ops::add(m, y), Ops::mul(e, Ops::set1(0.693359375)));
+        }
+
+        /*!
+         * \brief Arctangent of \a y / \a x, for finite values not both zero.
+         *
+         * The absolute value of the ratio is reduced to [0, 0.66] using the
+         * identities atan(t) = pi/2 - atan(1/t) and atan(t) = pi/4 +
+         * atan((t-1)/(t+1)), and the result approximated by a rational
+         * function. The ratio itself is never calculated, so that the range
+         * reduction needs a single division.
+         */
+        template<class Ops>
+        inline typename Ops::Vector atan(typename Ops::Vector y, typename Ops::Vector x)
+        {
+            typedef typename Ops::Vector Vector;
+
+            static const double P[] = {
+                -8.750608600031904122785E-1, -1.615753718733365076637E1,
+                -7.500855792314704667340E1,  -1.228866684490136173410E2,
+                -6.485021904942025371773E1
+            };
+            static const double Q[] = {
+                1.0,                         2.485846490142306297962E1,
+                1.650270098316988542046E2,   4.328810604912902668951E2,
+                4.853903996359136964868E2,   1.945506571482613964425E2
+            };
+            const double moreBits = 6.123233995736765886130E-17;
+
+            const Vector signMask = Ops::set1(-0.0);
+            const Vector sign = Ops::bitAnd(Ops::bitXor(x, y), signMask);
+            x = Ops::bitAndNot(signMask, x);
+            y = Ops::bitAndNot(signMask, y);
+
+            // Select the range reduction, comparing |y/x| with tan(3*pi/8) and 0.66
+            const Vector big = Ops::greaterThan(y, Ops::mul(x, Ops::set1(2.41421356237309504880)));
+            const Vector mid = Ops::bitAndNot(big, Ops::greaterThan(y, Ops::mul(x, Ops::set1(0.66))));
+
+            const Vector offset = Ops::select(big, Ops::set1(M_PI_2),
+                                              Ops::select(mid, Ops::set1(M_PI_4), Ops::set1(0.0)));
+            const Vector correction = Ops::select(big, Ops::set1(moreBits),
+                                                  Ops::select(mid, Ops::set1(0.5*moreBits), Ops::set1(0.0)));
+            const Vector numerator = Ops::select(big, Ops::sub(Ops::set1(0.0), x),
+                                                 Ops::select(mid, Ops::sub(y, x), y));
+            const Vector denominator = Ops::select(big, y, Ops::select(mid, Ops::add(y, x), x));
+            const Vector t = Ops::div(numerator, denominator);
+
+            const Vector z = Ops::mul(t, t);
+            Vector result = Ops::mul(z, Ops::div(polynomial<Ops>(z, P), polynomial<Ops>(z, Q)));
+            result = Ops::add(Ops::add(Ops::mul(t, result), t), correction);
+
+            return Ops::bitOr(Ops::add(offset, result), sign);
+        }
+
+        /*!
+         * \brief Converts \a count complex numbers, \a stride bytes apart,
+         * using the vector operations \a Ops.
+         *
+         * \sa complexToPolar()
+         */
+        template<class Ops>
+        void convert(const unsigned char *src, int stride, double *magnitude,
+                     double *phase, int count)
+        {
+            typedef typename Ops::Vector Vector;
+
+            const Vector maxValue = Ops::set1(1.7976931348623157E308);
+            const Vector minValue = Ops::set1(2.2250738585072014E-308);
+            const Vector toDecibels = Ops::set1(10/M_LN10);
+            const Vector toDegrees = Ops::set1(180/M_PI);
+
+            int i = 0;
+            for(; i + Ops::Width <= count; i += Ops::Width) {
+                const unsigned char *group = src + std::ptrdiff_t(i) * stride;
+
+                Vector real;
+                Vector imaginary;
+                Ops::loadComplex(group, stride, real, imaginary);
+
+                const Vector norm = Ops::add(Ops::mul(real, real), Ops::mul(imaginary, imaginary));
+
+                // Comparisons with NaN are always false
+                const Vector normal = Ops::bitAnd(Ops::greaterEqual(norm, minValue),
+                                                  Ops::lessEqual(norm, maxValue));
+                if(!Ops::all(normal)) {
+                    for(int j = 0; j < Ops::Width; ++j) {
+                        convert(group + std::ptrdiff_t(j) * stride, magnitude + i + j, phase + i + j);
+                    }
+                    continue;
+                }
+
+                Ops::store(magnitude + i, Ops::mul(log<Ops>(norm), toDecibels));
+                Ops::store(phase + i, Ops::mul(atan<Ops>(imaginary, real), toDegrees));
+            }
+
+            for(; i < count; ++i) {
+                convert(src + std::ptrdiff_t(i) * stride, magnitude + i, phase + i);
+            }
+        }
+
+        void convertAvx2(const unsigned char *src, int stride, double *magnitude,
+                         double *phase, int count);
+
+    } // namespace PolarKernel
+
+} // namespace Caneda
+
+#endif //POLAR_KERNEL_H
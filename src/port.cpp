@@ -20,12 +20,16 @@
 
 #include "port.h"
 
+#include "global.h"
+#include "graphicsscene.h"
 #include "settings.h"
 #include "wire.h"
 
 #include <QGraphicsItem>
 #include <QPainter>
+#include <QSet>
 #include <QStyleOptionGraphicsItem>
+#include <QVector>
 
 namespace Caneda
 {
@@ -39,13 +43,20 @@ namespace Caneda
         setFlag(ItemSendsGeometryChanges, true);
         setFlag(ItemSendsScenePositionChanges, true);
 
-        m_connections.append(this);
+        m_net = new Net;
+        m_net->ports.append(this);
+        m_netIndex = 0;
     }
 
     //! \brief Destroys the port object, removing all connections from the item
     Port::~Port()
     {
         disconnect();
+
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene) {
+            _scene->removePort(this);
+        }
     }
 
     /*!
@@ -67,33 +78,178 @@ namespace Caneda
      *
      *  Returns the list of equipotential connected ports, that is all
      *  connected ports including those connected by wires. This conforms the
-     *  net or node in the electrical sense. This method is to be used during
-     *  netlist creation to determine each unique net and group all components
-     *  connected ports under only one name.
+     *  net or node in the electrical sense.
      *
-     *  This method works in a recursive way, filling a list with the port
-     *  direct connections (contained in m_connections) and searching for
-     *  the connections of those ports connected to this one by a wire.
+     *  This method walks the port direct connections (contained in
+     *  m_net), and the connections of those ports connected to this
+     *  one by a wire, keeping a set of the visited ports so that each port
+     *  is visited only once. To group all the ports of a schematic into nets
+     *  use equipotentialNets() instead, which avoids walking each net once
+     *  per port.
      *
      *  \param connectedPorts List to fill with the connections of this port.
      *
-     *  \sa connections()
+     *  \sa connections(), equipotentialNets()
      */
     void Port::getEquipotentialPorts(QList<Port*> &connectedPorts)
     {
-        if(connectedPorts.contains(this)) {
+        QSet<Port*> visited = QSet<Port*>::fromList(connectedPorts);
+        if(visited.contains(this)) {
             return;
         }
 
-        connectedPorts << m_connections;
+        QList<Port*> pending;
+        pending << this;
+        visited << this;
+
+        while(!pending.isEmpty()) {
+            Port *port = pending.takeLast();
+
+            foreach(Port *other, port->m_net->ports) {
+                if(other != port && visited.contains(other)) {
+                    continue;
+                }
+                visited << other;
+                connectedPorts << other;
+
+                // Follow the wires to the port at their other end
+                if(other->parentItem()->type() == GraphicsItem::WireType) {
+                    Wire *_wire = static_cast<Wire*>(other->parentItem());
+                    Port *end = (_wire->port1() == other) ? _wire->port2() : _wire->port1();
+                    if(!visited.contains(end)) {
+                        visited << end;
+                        pending << end;
+                    }
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Disjoint-set forest of ports, used to group ports into nets.
+     *
+     * Each port is a node of the forest, and each tree is a net. Trees are
+     * joined by size, and paths are halved while looking for the root of a
+     * tree, so any sequence of operations runs in near linear time.
+     *
+     * \sa Port::equipotentialNets()
+     */
+    class PortForest
+    {
+    public:
+        explicit PortForest(int reserve)
+        {
+            m_index.reserve(reserve);
+            m_parent.reserve(reserve);
+            m_size.reserve(reserve);
+        }
+
+        //! \brief Returns the node of \a port, adding it if needed.
+        int node(Port *port)
+        {
+            QHash<Port*, int>::const_iterator it = m_index.constFind(port);
+            if(it != m_index.constEnd()) {
+                return it.value();
+            }
+
+            const int i = m_ports.size();
+            m_index.insert(port, i);
+            m_ports.append(port);
+            m_parent.append(i);
+            m_size.append(1);
+            return i;
+        }
+
+        //! \brief Returns the root of the tree of node \a i.
+        int find(int i)
+        {
+            while(m_parent.at(i) != i) {
+                m_parent[i] = m_parent.at(m_parent.at(i));
+                i = m_parent.at(i);
+            }
+            return i;
+        }
+
+        //! \brief Joins the trees of nodes \a a and \a b.
+        void join(int a, int b)
+        {
+            a = find(a);
+            b = find(b);
+            if(a == b) {
+                return;
+            }
+
+            if(m_size.at(a) < m_size.at(b)) {
+                qSwap(a, b);
+            }
+            m_parent[b] = a;
+            m_size[a] += m_size.at(b);
+        }
+
+        //! \brief Returns the number of nodes.
+        int size() const { return m_ports.size(); }
+        //! \brief Returns the port of node \a i.
+        Port* port(int i) const { return m_ports.at(i); }
+
+    private:
+        QHash<Port*, int> m_index;  //! \brief Node of each port.
+        QVector<Port*> m_ports;     //! \brief Port of each node.
+        QVector<int> m_parent;      //! \brief Parent of each node (itself for roots).
+        QVector<int> m_size;        //! \brief Size of each tree, valid for roots.
+    };
+
+    /*!
+     *  \brief Groups \a ports into nets, returning the net number of each
+     *  port.
+     *
+     *  Two ports belong to the same net if they are connected together, or if
+     *  they are the two ends of the same wire. Nets are built with a
+     *  disjoint-set forest (see PortForest), so the whole schematic is grouped
+     *  in near linear time, instead of walking each net once for every port
+     *  in it.
+     *
+     *  Nets are numbered from 1, in the order their first port appears in
+     *  \a ports. Ports reached through connections but missing in \a ports
+     *  are also included in the result.
+     *
+     *  \sa getEquipotentialPorts()
+     */
+    QHash<Port*, int> Port::equipotentialNets(const QList<Port*> &ports)
+    {
+        PortForest forest(ports.size());
+
+        foreach(Port *port, ports) {
+            const int i = forest.node(port);
 
-        foreach(Port *port, connectedPorts) {
+            // All connected ports share the same net
+            Port *first = port->m_net->ports.first();
+            if(first != port) {
+                forest.join(i, forest.node(first));
+            }
+
+            // Both ends of a wire are the same net
             if(port->parentItem()->type() == GraphicsItem::WireType) {
                 Wire *_wire = static_cast<Wire*>(port->parentItem());
-                _wire->port1()->getEquipotentialPorts(connectedPorts);
-                _wire->port2()->getEquipotentialPorts(connectedPorts);
+                forest.join(forest.node(_wire->port1()), forest.node(_wire->port2()));
+            }
+        }
+
+        // Number the nets in order of appearance
+        QHash<int, int> netOfRoot;
+        QHash<Port*, int> nets;
+        nets.reserve(forest.size());
+
+        for(int i = 0; i < forest.size(); ++i) {
+            const int root = forest.find(i);
+
+            QHash<int, int>::iterator it = netOfRoot.find(root);
+            if(it == netOfRoot.end()) {
+                it = netOfRoot.insert(root, netOfRoot.size() + 1);
             }
+            nets.insert(forest.port(i), it.value());
         }
+
+        return nets;
     }
 
     //! \brief Connect this port to \a other.
@@ -122,94 +278,180 @@ namespace Caneda
             return;
         }
 
-        // If the connections are same, they are already connected.
-        if(m_connections == other->m_connections) {
+        // If the nets are the same, they are already connected.
+        if(m_net == other->m_net) {
             qWarning() << "Port::connectTo() : The ports are already connected";
+            return;
         }
-        else {
-            // Create a list of connections by merging both lists of connections
-            // and replicating the list in all connected ports.
-            m_connections += other->m_connections;
-            foreach(Port *p, m_connections) {
-                p->m_connections = m_connections;
+
+        // Merge the smaller net into the larger one, so that each port is
+        // moved at most a logarithmic number of times.
+        NetPtr net = m_net;
+        NetPtr merged = other->m_net;
+        if(net->ports.size() < merged->ports.size()) {
+            qSwap(net, merged);
+        }
+
+        const int previousSize = net->ports.size();
+        const int mergedSize = merged->ports.size();
+        foreach(Port *p, merged->ports) {
+            p->m_net = net;
+            p->m_netIndex = net->ports.size();
+            net->ports.append(p);
+        }
+
+        // Update the ports whose drawing changed
+        updateNetItems(net, previousSize);
+        if(mergedSize <= 2) {
+            foreach(Port *p, merged->ports) {
+                p->parentItem()->update();
             }
         }
 
-        // Update all ports parents.
-        foreach(Port *p, m_connections) {
-            p->parentItem()->update();
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene) {
+            _scene->joinElectricalNets(this, other);
         }
+
+        notifyConnectionsChanged();
     }
 
     /*!
      * \brief Disconnect a port
      *
-     * A disconnect operation must remove this port from every other port's
-     * list of connections (effectively disconnecting all ports currently
+     * A disconnect operation must remove this port from the net of
+     * connected ports (effectively disconnecting all ports currently
      * connected), thus avoiding false or erroneous connections to remain as
-     * valid.
+     * valid. The remaining ports are kept connected together.
      */
     void Port::disconnect()
     {
         // Check if there is any connection
-        if(m_connections.size() <= 1) {
+        if(m_net->ports.size() <= 1) {
             return;
         }
 
-        // Disconnect this port from every connected port
-        foreach(Port *p, m_connections) {
-            p->m_connections.removeAll(this);
-            p->parentItem()->update();
-        }
+        // Remove this port from the net, moving the last port to its place
+        NetPtr net = m_net;
+        const int previousSize = net->ports.size();
+        Port *last = net->ports.last();
+        net->ports[m_netIndex] = last;
+        last->m_netIndex = m_netIndex;
+        net->ports.removeLast();
 
-        m_connections.clear();
-        m_connections.append(this);
+        m_net = new Net;
+        m_net->ports.append(this);
+        m_netIndex = 0;
 
-        // Update parent item.
+        // Update the ports whose drawing changed
+        updateNetItems(net, previousSize);
         parentItem()->update();
+
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene) {
+            _scene->invalidateElectricalNets();
+        }
+
+        notifyConnectionsChanged();
+    }
+
+    /*!
+     * \brief Updates the parents of the ports of \a net, if the size of the
+     * net changed the way they are drawn.
+     *
+     * Ports are drawn differently only for nets of up to three ports (see
+     * paint()), so big nets are not updated when ports are connected to or
+     * disconnected from them.
+     *
+     * \param previousSize Size of the net before the change.
+     */
+    void Port::updateNetItems(const NetPtr &net, int previousSize)
+    {
+        if(previousSize <= 3 || net->ports.size() <= 3) {
+            foreach(Port *p, net->ports) {
+                p->parentItem()->update();
+            }
+        }
+    }
+
+    //! \brief Notifies the scene (if any) that the connections of this port changed.
+    void Port::notifyConnectionsChanged()
+    {
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene) {
+            _scene->notifyConnectionsChanged();
+        }
+    }
+
+    //! \brief Returns true if this port belongs to the highlighted net of its scene.
+    bool Port::isNetHighlighted()
+    {
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        return _scene && _scene->isNetHighlighted(this);
     }
 
     //! \brief Check if port \a other is connected to this port.
-    bool Port::isConnectedTo(Port *other)
+    bool Port::isConnectedTo(Port *other) const
     {
-        bool retVal = m_connections == other->m_connections &&
-            m_connections.contains(other);
-        return retVal;
+        return m_net == other->m_net;
     }
 
     //! \brief Returns true if this port is connected to any other port
     bool Port::hasAnyConnection() const
     {
-        bool retVal = (m_connections.size() > 1);
-        return retVal;
+        return m_net->ports.size() > 1;
     }
 
-    //! \brief Finds a coinciding port on schematic.
+    /*!
+     * \brief Finds a coinciding port on schematic.
+     *
+     * The port is looked up in the ports index of the scene, which is kept
+     * up to date by itemChange().
+     *
+     * \sa GraphicsScene::portsAt()
+     */
     Port* Port::findCoincidingPort() const
     {
-        if(!scene()) {
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(!_scene) {
             return 0;
         }
 
-        QList<QGraphicsItem*> collisions =
-            parentItem()->collidingItems(Qt::IntersectsItemBoundingRect);
-
-        foreach(QGraphicsItem *item, collisions) {
-            if(canedaitem_cast<GraphicsItem*>(item)) {
+        foreach(Port *p, _scene->portsAt(scenePos())) {
+            if(p->parentItem() != parentItem() && p->m_net != m_net) {
+                return p;
+            }
+        }
 
-                QList<Port*> ports = canedaitem_cast<GraphicsItem*>(item)->ports();
-                foreach(Port *p, ports) {
-                    if(p->scenePos() == scenePos() &&
-                            p->parentItem() != parentItem() &&
-                            !m_connections.contains(p)) {
-                        return p;
-                    }
-                }
+        return 0;
+    }
 
+    /*!
+     * \brief Keeps the ports index of the scene up to date.
+     *
+     * The port is added to the index of the scene it is inserted into,
+     * removed from the index of the scene it is removed from, and updated
+     * whenever its scene position changes (either because the port or any
+     * of its ancestors moved or was transformed).
+     *
+     * \sa GraphicsScene::addPort(), findCoincidingPort()
+     */
+    QVariant Port::itemChange(GraphicsItemChange change, const QVariant &value)
+    {
+        if(change == ItemSceneChange) {
+            GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+            if(_scene) {
+                _scene->removePort(this);
+            }
+        }
+        else if(change == ItemSceneHasChanged || change == ItemScenePositionHasChanged) {
+            GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+            if(_scene) {
+                _scene->addPort(this);
             }
         }
 
-        return 0;
+        return QGraphicsItem::itemChange(change, value);
     }
 
     /*!
@@ -221,26 +463,29 @@ namespace Caneda
      */
     void Port::paint(QPainter *painter, const QStyleOptionGraphicsItem* option, QWidget*)
     {
+        // Ports are too small to be seen when zoomed out
+        if(option->levelOfDetailFromTransform(painter->worldTransform()) < Caneda::PortsLevelOfDetail) {
+            return;
+        }
+
         // Save pen
         QPen savedPen = painter->pen();
 
         // Set global pen settings
-        Settings *settings = Settings::instance();
-        if(m_connections.size() <= 1) {
+        const RenderSettings &settings = Settings::instance()->renderSettings();
+        if(m_net->ports.size() <= 1) {
             painter->setPen(QPen(Qt::darkRed));
             painter->setBrush(Qt::NoBrush);
             painter->drawEllipse(portEllipse);
         }
-        else if(m_connections.size() > 2 && parentItem()->isSelected()) {
-            painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
-            painter->setBrush(QBrush(settings->currentValue("gui/selectionColor").value<QColor>()));
+        else if(m_net->ports.size() > 2 && (parentItem()->isSelected() || isNetHighlighted())) {
+            painter->setPen(settings.selectionPen);
+            painter->setBrush(settings.selectionBrush);
             painter->drawEllipse(portEllipse.adjusted(1,1,-1,-1));  // Adjust the ellipse to be just a little smaller than the open port
         }
-        else if(m_connections.size() > 2) {
-            painter->setPen(QPen(settings->currentValue("gui/lineColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
-            painter->setBrush(QBrush(settings->currentValue("gui/lineColor").value<QColor>()));
+        else if(m_net->ports.size() > 2) {
+            painter->setPen(settings.linePen);
+            painter->setBrush(settings.lineBrush);
             painter->drawEllipse(portEllipse.adjusted(1,1,-1,-1));  // Adjust the ellipse to be just a little smaller than the open port
         }
 
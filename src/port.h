@@ -23,8 +23,10 @@
 
 #include "graphicsitem.h"
 
+#include <QHash>
 #include <QList>
 #include <QSharedData>
+#include <QVector>
 
 namespace Caneda
 {
@@ -43,6 +45,25 @@ namespace Caneda
         QString name;
     };
 
+    // Forward declarations
+    class Port;
+
+    /*!
+     * \brief Set of ports directly connected together.
+     *
+     * All the ports connected together point to the same Net, which is
+     * reference counted and deleted when no port uses it anymore. An
+     * unconnected port has a net of its own, with only that port.
+     *
+     * \sa Port
+     */
+    struct Net : public QSharedData
+    {
+        QVector<Port*> ports;  //! \brief Connected ports (the port itself included).
+    };
+
+    typedef QExplicitlySharedDataPointer<Net> NetPtr;
+
     /*!
      * \brief The Port class is an electric port graphical representation, that
      * allows components to be connected together through the use of wires.
@@ -72,14 +93,15 @@ namespace Caneda
 
         GraphicsItem* parentItem() const;
 
-        //! Returns a pointer to list of connected ports
-        QList<Port*> *connections() { return &(m_connections); }
+        //! Returns the list of connected ports (including this port).
+        const QVector<Port*>& connections() const { return m_net->ports; }
         void getEquipotentialPorts(QList<Caneda::Port *> &connectedPorts);
+        static QHash<Port*, int> equipotentialNets(const QList<Port*> &ports);
 
         void connectTo(Port *other);
         void disconnect();
 
-        bool isConnectedTo(Port *other);
+        bool isConnectedTo(Port *other) const;
         bool hasAnyConnection() const;
 
         Port* findCoincidingPort() const;
@@ -88,9 +110,17 @@ namespace Caneda
         QRectF boundingRect() const { return portEllipse; }
         void paint(QPainter *painter, const QStyleOptionGraphicsItem* option, QWidget*);
 
+    protected:
+        QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
     private:
+        void notifyConnectionsChanged();
+        bool isNetHighlighted();
+        static void updateNetItems(const NetPtr &net, int previousSize);
+
         QString m_name;
-        QList<Port*> m_connections;
+        NetPtr m_net;      //! \brief Net shared with all the connected ports.
+        int m_netIndex;    //! \brief Position of this port in the net.
     };
 
 } // namespace Caneda
@@ -20,6 +20,7 @@
 #include "portsymbol.h"
 
 #include "graphicsitem.h"
+#include "graphicsscene.h"
 #include "portsymboldialog.h"
 #include "settings.h"
 #include "xmlutilities.h"
@@ -70,6 +71,12 @@ namespace Caneda
         m_label->setText(newLabel);
         updateGeometry();
 
+        // The label names the net of the port in the netlist
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene) {
+            _scene->notifyConnectionsChanged();
+        }
+
         return true;
     }
 
@@ -121,26 +128,24 @@ namespace Caneda
         QPen savedPen = painter->pen();
 
         // Set global pen settings
-        Settings *settings = Settings::instance();
+        const RenderSettings &settings = Settings::instance()->renderSettings();
         if(option->state & QStyle::State_Selected) {
-            painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
+            painter->setPen(settings.selectionPen);
 
             // Set the label font settings
-            m_label->setBrush(QBrush(settings->currentValue("gui/selectionColor").value<QColor>()));
+            m_label->setBrush(settings.selectionBrush);
         }
         else {
-            painter->setPen(QPen(settings->currentValue("gui/lineColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
+            painter->setPen(settings.linePen);
 
             // Set the label font settings
-            m_label->setBrush(QBrush(settings->currentValue("gui/foregroundColor").value<QColor>()));
+            m_label->setBrush(settings.foregroundBrush);
         }
 
         // Draw the port symbol if it is a termination point or ground
         if(m_label->text().toLower() == "ground" ||
                 m_label->text().toLower() == "gnd" ||
-                port()->connections()->size() <= 2) {
+                port()->connections().size() <= 2) {
             painter->drawPath(m_symbol);
         }
 
@@ -20,7 +20,9 @@
 
 #include "property.h"
 
+#include "component.h"
 #include "global.h"
+#include "graphicsscene.h"
 #include "propertydialog.h"
 #include "settings.h"
 #include "xmlutilities.h"
@@ -177,6 +179,7 @@ namespace Caneda
     {
         m_propertyMap.insert(key, prop);
         updatePropertyDisplay();  // This is necessary to update the properties display on a scene
+        notifyComponentChanged();
     }
 
     //! \brief Sets property \a key to \a value in the PropertyMap.
@@ -185,6 +188,7 @@ namespace Caneda
         if(m_propertyMap.contains(key)) {
             m_propertyMap[key].setValue(value);
             updatePropertyDisplay();  // This is necessary to update the properties display on a scene
+            notifyComponentChanged();
         }
     }
 
@@ -203,6 +207,7 @@ namespace Caneda
     {
         m_propertyMap = propMap;
         updatePropertyDisplay();  // This is necessary to update the properties display on a scene
+        notifyComponentChanged();
     }
 
     /*!
@@ -298,18 +303,21 @@ namespace Caneda
     void PropertyGroup::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
             QWidget *widget)
     {
+        // Texts are too small to be read when zoomed out
+        if(option->levelOfDetailFromTransform(painter->worldTransform()) < Caneda::TextLevelOfDetail) {
+            return;
+        }
+
         // Save pen
         QPen savedPen = painter->pen();
 
         // Set global pen settings
-        Settings *settings = Settings::instance();
+        const RenderSettings &settings = Settings::instance()->renderSettings();
         if(isSelected()) {
-            painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
+            painter->setPen(settings.selectionPen);
         }
         else {
-            painter->setPen(QPen(settings->currentValue("gui/foregroundColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
+            painter->setPen(settings.foregroundPen);
         }
 
         // Paint the property text
@@ -319,6 +327,19 @@ namespace Caneda
         painter->setPen(savedPen);
     }
 
+    /*!
+     * \brief Notifies the scene (if any) that the properties of the parent
+     * component changed, as they are used to generate its netlist.
+     */
+    void PropertyGroup::notifyComponentChanged()
+    {
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        Component *component = canedaitem_cast<Component*>(parentItem());
+        if(_scene && component) {
+            _scene->notifyComponentChanged(component);
+        }
+    }
+
     //! \brief Helper method to write all properties in \a m_propertyMap to xml.
     void PropertyGroup::writeProperties(Caneda::XmlWriter *writer)
     {
@@ -371,6 +392,7 @@ namespace Caneda
         }
 
         updatePropertyDisplay();
+        notifyComponentChanged();
     }
 
     //! \copydoc GraphicsItem::launchPropertiesDialog()
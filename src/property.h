@@ -152,6 +152,8 @@ namespace Caneda
         void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event);
 
     private:
+        void notifyComponentChanged();
+
         //! QMap holding actual properties.
         PropertyMap m_propertyMap;
 
@@ -63,6 +63,8 @@ namespace Caneda
         defaultSettings["gui/lineColor"] = QVariant(QColor(Qt::blue));
         defaultSettings["gui/selectionColor"] = QVariant(QColor(255, 128, 0)); // Dark orange
         defaultSettings["gui/lineWidth"] = QVariant(int(1));
+        defaultSettings["gui/vectorZoom"] = QVariant(qreal(4.0));
+        defaultSettings["gui/wireLayer"] = QVariant(bool(false));
 
         defaultSettings["gui/hdl/keyword"]= QVariant(QVariant(QColor(Qt::black)));
         defaultSettings["gui/hdl/type"]= QVariant(QVariant(QColor(Qt::blue)));
@@ -85,6 +87,7 @@ namespace Caneda
         defaultSettings["sim/simulationEngine"] = QVariant(QString("ngspice"));  //! \todo In the future this could be replaced by an enum, to avoid problems
         defaultSettings["sim/simulationCommand"] = QVariant(QString("ngspice -b -r %filename.raw %filename.net"));
         defaultSettings["sim/outputFormat"] = QVariant(QString("binary"));  //! \todo In the future this could be replaced by an enum, to avoid problems
+        defaultSettings["sim/liveWaveforms"] = QVariant(bool(true));
 
         defaultSettings["shortcuts/fileNew"] = QVariant(QKeySequence(QKeySequence::New));
         defaultSettings["shortcuts/fileOpen"] = QVariant(QKeySequence(QKeySequence::Open));
@@ -141,6 +144,7 @@ namespace Caneda
         defaultSettings["shortcuts/helpIndex"] = QVariant(QKeySequence(QKeySequence::HelpContents));
 
         currentSettings = defaultSettings;
+        updateRenderSettings();
     }
 
     //! \copydoc MainWindow::instance()
@@ -191,6 +195,39 @@ namespace Caneda
     void Settings::setCurrentValue(const QString& key, const QVariant& value)
     {
         currentSettings[key] = value.isValid() ? value : defaultSettings[key];
+
+        if(key.startsWith("gui/")) {
+            updateRenderSettings();
+        }
+    }
+
+    /*!
+     * \brief Rebuilds the render settings from the current values.
+     *
+     * \sa renderSettings()
+     */
+    void Settings::updateRenderSettings()
+    {
+        RenderSettings &r = currentRenderSettings;
+
+        r.foregroundColor = currentValue("gui/foregroundColor").value<QColor>();
+        r.backgroundColor = currentValue("gui/backgroundColor").value<QColor>();
+        r.lineColor = currentValue("gui/lineColor").value<QColor>();
+        r.selectionColor = currentValue("gui/selectionColor").value<QColor>();
+        r.lineWidth = currentValue("gui/lineWidth").toInt();
+        r.gridVisible = currentValue("gui/gridVisible").toBool();
+        r.vectorZoom = currentValue("gui/vectorZoom").toReal();
+        r.wireLayer = currentValue("gui/wireLayer").toBool();
+
+        r.foregroundPen = QPen(r.foregroundColor, r.lineWidth);
+        r.linePen = QPen(r.lineColor, r.lineWidth);
+        r.selectionPen = QPen(r.selectionColor, r.lineWidth);
+        r.gridPen = QPen(r.foregroundColor, 0);
+
+        r.foregroundBrush = QBrush(r.foregroundColor);
+        r.backgroundBrush = QBrush(r.backgroundColor);
+        r.lineBrush = QBrush(r.lineColor);
+        r.selectionBrush = QBrush(r.selectionColor);
     }
 
     /*!
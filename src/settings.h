@@ -21,14 +21,50 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
+#include <QBrush>
+#include <QColor>
 #include <QMap>
 #include <QObject>
+#include <QPen>
 
 //Forward declarations
 class QVariant;
 
 namespace Caneda
 {
+    /*!
+     * \brief Snapshot of the settings used while painting items.
+     *
+     * Reading a setting with Settings::currentValue() involves string keyed
+     * lookups and a QVariant conversion, which is too slow to be done in each
+     * paint event. This structure holds the drawing related settings already
+     * converted, together with the pens and brushes built from them. It is
+     * rebuilt by Settings whenever a "gui/" setting changes.
+     *
+     * \sa Settings::renderSettings()
+     */
+    struct RenderSettings
+    {
+        QColor foregroundColor;  //!< \brief Color of texts and the grid.
+        QColor backgroundColor;  //!< \brief Color of the scene background.
+        QColor lineColor;        //!< \brief Color of wires and symbols.
+        QColor selectionColor;   //!< \brief Color of selected items.
+        int lineWidth;           //!< \brief Width of wires and symbols.
+        bool gridVisible;        //!< \brief True if the grid must be drawn.
+        qreal vectorZoom;        //!< \brief Zoom level from which symbols are not drawn from pixmaps.
+        bool wireLayer;          //!< \brief True if unselected wires are drawn in one batch by the scene.
+
+        QPen foregroundPen;      //!< \brief Pen of foregroundColor and lineWidth.
+        QPen linePen;            //!< \brief Pen of lineColor and lineWidth.
+        QPen selectionPen;       //!< \brief Pen of selectionColor and lineWidth.
+        QPen gridPen;            //!< \brief Cosmetic pen of foregroundColor.
+
+        QBrush foregroundBrush;  //!< \brief Brush of foregroundColor.
+        QBrush backgroundBrush;  //!< \brief Brush of backgroundColor.
+        QBrush lineBrush;        //!< \brief Brush of lineColor.
+        QBrush selectionBrush;   //!< \brief Brush of selectionColor.
+    };
+
     /*!
      * \brief This class handles all of Caneda's settings.
      *
@@ -52,14 +88,20 @@ namespace Caneda
 
         void setCurrentValue(const QString& key, const QVariant& value);
 
+        //! \brief Returns the settings used while painting items.
+        const RenderSettings& renderSettings() const { return currentRenderSettings; }
+
         bool load();
         bool save();
 
     private:
         explicit Settings(QObject *parent = 0);
 
+        void updateRenderSettings();
+
         QMap<QString, QVariant> defaultSettings;
         QMap<QString, QVariant> currentSettings;
+        RenderSettings currentRenderSettings;
     };
 
 } // namespace Caneda
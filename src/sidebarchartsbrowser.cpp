@@ -19,10 +19,13 @@
 
 #include "sidebarchartsbrowser.h"
 
+#include "chartscene.h"
 #include "chartview.h"
 #include "documentviewmanager.h"
+#include "idocument.h"
 #include "iview.h"
 
+#include <QComboBox>
 #include <QHBoxLayout>
 #include <QHeaderView>
 #include <QLabel>
@@ -182,6 +185,15 @@ namespace Caneda
         QVBoxLayout *layoutTop = new QVBoxLayout(this);
         QHBoxLayout *layoutHorizontal = new QHBoxLayout();
         QVBoxLayout *layoutButtons = new QVBoxLayout();
+        QHBoxLayout *layoutPlot = new QHBoxLayout();
+
+        // Set plot selector properties. The plots are set in updateChartSeriesMap().
+        QLabel *labelPlot = new QLabel(tr("Plot:"), this);
+        m_plotSelector = new QComboBox(this);
+        m_plotSelector->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLength);
+        layoutPlot->addWidget(labelPlot);
+        layoutPlot->addWidget(m_plotSelector, 1);
+        layoutTop->addLayout(layoutPlot);
 
         // Set lineedit properties
         m_filterEdit = new QLineEdit(this);
@@ -225,6 +237,7 @@ namespace Caneda
         // Signals and slots connections
         connect(m_filterEdit, SIGNAL(textChanged(const QString &)),
                 this, SLOT(filterTextChanged()));
+        connect(m_plotSelector, SIGNAL(activated(int)), this, SLOT(plotChanged(int)));
 
         connect(buttonAll, SIGNAL(clicked()), this, SLOT(selectAll()));
         connect(buttonNone, SIGNAL(clicked()), this, SLOT(selectNone()));
@@ -244,6 +257,23 @@ namespace Caneda
         m_proxyModel->setFilterRegExp(regExp);
     }
 
+    /*!
+     * \brief Displays the plot selected by the user.
+     *
+     * The data of the plot is read only when first selected (see
+     * SimulationDocument::setCurrentPlot()), after which the list of
+     * available waveforms is updated.
+     */
+    void SidebarChartsBrowser::plotChanged(int plot)
+    {
+        DocumentViewManager *manager = DocumentViewManager::instance();
+        SimulationDocument *document = qobject_cast<SimulationDocument*>(manager->currentDocument());
+
+        if(document) {
+            document->setCurrentPlot(plot);  // Also updates the sidebar
+        }
+    }
+
     //! \brief Select all available waveforms
     void SidebarChartsBrowser::selectAll()
     {
@@ -341,6 +371,12 @@ namespace Caneda
         DocumentViewManager *manager = DocumentViewManager::instance();
         ChartView *view = static_cast<ChartView*>(manager->currentView()->toWidget());
 
+        // Populate the plots list
+        m_plotSelector->clear();
+        m_plotSelector->addItems(view->chartScene()->plotNames());
+        m_plotSelector->setCurrentIndex(view->chartScene()->currentPlot());
+        m_plotSelector->setEnabled(m_plotSelector->count() > 1);
+
         // Populate the waveforms list
         QwtPlotItemList list = view->itemList(QwtPlotItem::Rtti_PlotCurve);
         m_chartSeriesMap.clear();
@@ -24,6 +24,7 @@
 #include <QWidget>
 
 // Forward declarations.
+class QComboBox;
 class QLineEdit;
 class QPushButton;
 class QSortFilterProxyModel;
@@ -88,7 +89,10 @@ namespace Caneda
      * ChartView plot.
      *
      * This dialog presents to the user the properties of the selected
-     * simulation plot (ChartView) and the visible waveforms.
+     * simulation plot (ChartView) and the visible waveforms. When the
+     * simulation results contain several plots (for example an operating
+     * point and a transient analysis), the user can also select the plot
+     * to be displayed.
      *
      * This class handles the user interface part of the dialog, and
      * presentation part to the user, while SidebarChartsModel class
@@ -108,6 +112,7 @@ namespace Caneda
 
     private Q_SLOTS:
         void filterTextChanged();
+        void plotChanged(int plot);
 
         void selectAll();
         void selectNone();
@@ -123,6 +128,7 @@ namespace Caneda
 
         ChartSeriesMap m_chartSeriesMap;
 
+        QComboBox *m_plotSelector;
         QLineEdit *m_filterEdit;
         QPushButton *buttonAll, *buttonNone, *buttonVoltages, *buttonCurrents;
     };
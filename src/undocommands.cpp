@@ -102,6 +102,58 @@ namespace Caneda
     }
 
 
+    /*************************************************************************
+     *                            MoveItemsCmd                               *
+     *************************************************************************/
+    /*!
+     * \brief Constructs a command moving each item of \a items from the
+     * scene position in \a init to the one in \a final, at the same index.
+     *
+     * \copydetails MoveItemCmd::MoveItemCmd()
+     */
+    MoveItemsCmd::MoveItemsCmd(const QVector<GraphicsItem*> &items,
+                               const QVector<QPointF> &init,
+                               const QVector<QPointF> &final,
+                               QUndoCommand *parent) :
+        QUndoCommand(parent),
+        m_items(items),
+        m_initialPos(init),
+        m_finalPos(final)
+    {
+        Q_ASSERT(m_items.size() == m_initialPos.size());
+        Q_ASSERT(m_items.size() == m_finalPos.size());
+    }
+
+    //! \copydoc MoveItemCmd::undo()
+    void MoveItemsCmd::undo()
+    {
+        moveItems(m_initialPos);
+    }
+
+    //! \copydoc MoveItemCmd::redo()
+    void MoveItemsCmd::redo()
+    {
+        moveItems(m_finalPos);
+    }
+
+    /*!
+     * \brief Moves each item to the scene position at the same index in
+     * \a positions.
+     */
+    void MoveItemsCmd::moveItems(const QVector<QPointF> &positions)
+    {
+        for(int i = 0; i < m_items.size(); ++i) {
+            GraphicsItem *item = m_items.at(i);
+            if(item->parentItem()) {
+                item->setPos(item->mapToParent(item->mapFromScene(positions.at(i))));
+            }
+            else {
+                item->setPos(positions.at(i));
+            }
+        }
+    }
+
+
     /*************************************************************************
      *                           DisconnectCmd                               *
      *************************************************************************/
@@ -26,6 +26,7 @@
 
 #include <QPair>
 #include <QUndoCommand>
+#include <QVector>
 
 namespace Caneda
 {
@@ -91,6 +92,34 @@ namespace Caneda
         QPointF m_finalPos;
     };
 
+    /*!
+     * \brief Move multiple items command implementation of the
+     * QUndoCommand/QUndoStack pattern for Qt's Undo Framework.
+     *
+     * Unlike a macro of MoveItemCmd, the items and their positions are kept
+     * in compact arrays, and all the items are moved in one batch.
+     *
+     * \copydetails MoveItemCmd
+     */
+    class MoveItemsCmd : public QUndoCommand
+    {
+    public:
+        explicit MoveItemsCmd(const QVector<GraphicsItem*> &items,
+                              const QVector<QPointF> &init,
+                              const QVector<QPointF> &final,
+                              QUndoCommand *parent = 0);
+
+        void undo();
+        void redo();
+
+    private:
+        void moveItems(const QVector<QPointF> &positions);
+
+        QVector<GraphicsItem*> m_items;
+        QVector<QPointF> m_initialPos;
+        QVector<QPointF> m_finalPos;
+    };
+
     /*!
      * \brief Disconnect command implementation of the QUndoCommand/QUndoStack
      * pattern for Qt's Undo Framework.
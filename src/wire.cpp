@@ -22,6 +22,7 @@
 
 #include "actionmanager.h"
 #include "global.h"
+#include "graphicsscene.h"
 #include "settings.h"
 #include "xmlutilities.h"
 
@@ -63,6 +64,12 @@ namespace Caneda
     //! \brief Destructor.
     Wire::~Wire()
     {
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene) {
+            _scene->removeWire(this);
+            _scene->updateWireLayer(m_layerRect);
+        }
+
         qDeleteAll(m_ports);
     }
 
@@ -111,6 +118,14 @@ namespace Caneda
         path = stroker.createStroke(path);
 
         GraphicsItem::setShapeAndBoundRect(path, boundingRect());
+
+        // Keep the wire segments index of the scene up to date
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene) {
+            _scene->addWire(this);
+        }
+
+        updateLayer();
     }
 
     //! \brief Returns bounding rectangle arround the wire
@@ -137,18 +152,30 @@ namespace Caneda
     void Wire::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
             QWidget *widget)
     {
+        // Unselected wires may be drawn all at once by the scene
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene && _scene->isInWireLayer(this)) {
+            return;
+        }
+
         // Save pen
         QPen savedPen = painter->pen();
 
         // Set global pen settings
-        Settings *settings = Settings::instance();
-        if(option->state & QStyle::State_Selected) {
-            painter->setPen(QPen(settings->currentValue("gui/selectionColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
+        const RenderSettings &settings = Settings::instance()->renderSettings();
+        if(option->state & QStyle::State_Selected ||
+                (_scene && _scene->isNetHighlighted(port1()))) {
+            painter->setPen(settings.selectionPen);
         }
         else {
-            painter->setPen(QPen(settings->currentValue("gui/lineColor").value<QColor>(),
-                                 settings->currentValue("gui/lineWidth").toInt()));
+            painter->setPen(settings.linePen);
+        }
+
+        // When zoomed out, hairlines are drawn faster and look the same
+        if(option->levelOfDetailFromTransform(painter->worldTransform()) < Caneda::WiresLevelOfDetail) {
+            QPen pen = painter->pen();
+            pen.setWidth(0);
+            painter->setPen(pen);
         }
 
         // Draw the wire
@@ -219,4 +246,64 @@ namespace Caneda
         _menu->exec(event->screenPos());
     }
 
+    /*!
+     * \brief Keeps the wire segments index and the wire layer of the scene
+     * up to date.
+     *
+     * The wire is added to the index of the scene it is inserted into,
+     * removed from the index of the scene it is removed from, and updated
+     * whenever it is moved or transformed. Changes in the wire's shape are
+     * handled by updateGeometry().
+     *
+     * \sa GraphicsScene::addWire(), updateLayer()
+     */
+    QVariant Wire::itemChange(GraphicsItemChange change, const QVariant &value)
+    {
+        if(change == ItemSceneChange) {
+            GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+            if(_scene) {
+                _scene->removeWire(this);
+                _scene->updateWireLayer(m_layerRect);
+            }
+            m_layerRect = QRectF();
+        }
+        else if(change == ItemSceneHasChanged || change == ItemScenePositionHasChanged) {
+            GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+            if(_scene) {
+                _scene->addWire(this);
+            }
+            updateLayer();
+        }
+        else if(change == ItemSelectedHasChanged || change == ItemVisibleHasChanged) {
+            updateLayer();
+        }
+
+        return GraphicsItem::itemChange(change, value);
+    }
+
+    /*!
+     * \brief Redraws the wire layer of the scene where the wire was and
+     * where it is now.
+     *
+     * The wire layer is drawn with the background, which the views cache.
+     * This is called whenever the wire is moved, reshaped, selected or
+     * hidden, so that only the areas it changed are drawn again.
+     *
+     * \sa GraphicsScene::drawWireLayer()
+     */
+    void Wire::updateLayer()
+    {
+        const QRectF rect = isVisible() ? sceneBoundingRect() : QRectF();
+
+        GraphicsScene *_scene = qobject_cast<GraphicsScene*>(scene());
+        if(_scene) {
+            _scene->updateWireLayer(m_layerRect);
+            if(rect != m_layerRect) {
+                _scene->updateWireLayer(rect);
+            }
+        }
+
+        m_layerRect = rect;
+    }
+
 } // namespace Caneda
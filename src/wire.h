@@ -80,6 +80,13 @@ namespace Caneda
 
     protected:
         void contextMenuEvent(QGraphicsSceneContextMenuEvent *event);
+        QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
+    private:
+        void updateLayer();
+
+        //! \brief Scene area last covered by the wire in the wire layer.
+        QRectF m_layerRect;
     };
 
 } // namespace Caneda